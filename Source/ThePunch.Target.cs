@@ -9,5 +9,8 @@ public class ThePunchTarget : TargetRules
 	{
 		Type = TargetType.Game;
 		ExtraModuleNames.Add("ThePunch");
+
+		// optional feature modules, loaded at startup by FThePunchHooks::LoadOptionalModules
+		ExtraModuleNames.AddRange(new string[] { "ThePunchVR", "ThePunchAudio", "ThePunchDebug" });
 	}
 }
@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ActorPool.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchImpactEffect.h"
+#include "CombatBenchmarks.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Acquire Pooled Actor"), STAT_AcquirePooledActor, STATGROUP_ThePunch);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Parked Actors"), STAT_ParkedActors, STATGROUP_ThePunch);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actor Pool Misses"), STAT_ActorPoolMisses, STATGROUP_ThePunch);
+
+void FActorPool::Prewarm(UWorld* World, UClass* Class, int32 Count)
+{
+	if (World == NULL || Class == NULL)
+	{
+		return;
+	}
+
+	for (int32 Index = GetNumParked(Class); Index < Count; ++Index)
+	{
+		AActor* Actor = Spawn(World, Class, FTransform::Identity);
+
+		if (Actor)
+		{
+			Release(Actor);
+		}
+	}
+}
+
+AActor* FActorPool::Acquire(UWorld* World, UClass* Class, const FTransform& Transform)
+{
+	SCOPE_CYCLE_COUNTER(STAT_AcquirePooledActor);
+
+	TArray<TWeakObjectPtr<AActor>>* Actors = Parked.Find(Class);
+
+	while (Actors && Actors->Num() > 0)
+	{
+		AActor* Actor = Actors->Pop(false).Get();
+
+		DEC_DWORD_STAT(STAT_ParkedActors);
+
+		if (Actor && !Actor->IsPendingKill() && Actor->GetWorld() == World)
+		{
+			Unpark(Actor, Transform);
+			return Actor;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_ActorPoolMisses);
+
+	AActor* Actor = Spawn(World, Class, Transform);
+
+	if (Actor)
+	{
+		Unpark(Actor, Transform);
+	}
+
+	return Actor;
+}
+
+void FActorPool::Release(AActor* Actor)
+{
+	if (Actor == NULL || Actor->IsPendingKill())
+	{
+		return;
+	}
+
+	Park(Actor);
+
+	Parked.FindOrAdd(Actor->GetClass()).Add(Actor);
+
+	INC_DWORD_STAT(STAT_ParkedActors);
+}
+
+void FActorPool::Empty()
+{
+	for (TPair<UClass*, TArray<TWeakObjectPtr<AActor>>>& Pair : Parked)
+	{
+		for (const TWeakObjectPtr<AActor>& Actor : Pair.Value)
+		{
+			if (Actor.IsValid())
+			{
+				Actor->Destroy();
+			}
+
+			DEC_DWORD_STAT(STAT_ParkedActors);
+		}
+	}
+
+	Parked.Empty();
+}
+
+int32 FActorPool::GetNumParked(UClass* Class) const
+{
+	const TArray<TWeakObjectPtr<AActor>>* Actors = Parked.Find(Class);
+
+	return Actors ? Actors->Num() : 0;
+}
+
+AActor* FActorPool::Spawn(UWorld* World, UClass* Class, const FTransform& Transform)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<AActor>(Class, Transform, SpawnParams);
+}
+
+void FActorPool::Park(AActor* Actor)
+{
+	// fighters leave the match first, hiding alone would keep them targetable
+	if (AThePunchCharacter* Fighter = Cast<AThePunchCharacter>(Actor))
+	{
+		Fighter->SetIsParked(true);
+	}
+	else if (AThePunchImpactEffect* Effect = Cast<AThePunchImpactEffect>(Actor))
+	{
+		Effect->Stop();
+	}
+
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+}
+
+void FActorPool::Unpark(AActor* Actor, const FTransform& Transform)
+{
+	Actor->SetActorTransform(Transform, false, NULL, ETeleportType::TeleportPhysics);
+	Actor->SetActorHiddenInGame(false);
+	Actor->SetActorEnableCollision(true);
+	Actor->SetActorTickEnabled(true);
+
+	if (AThePunchCharacter* Fighter = Cast<AThePunchCharacter>(Actor))
+	{
+		Fighter->SetIsParked(false);
+	}
+	else if (AThePunchImpactEffect* Effect = Cast<AThePunchImpactEffect>(Actor))
+	{
+		Effect->Play();
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+// a respawn through SpawnActor against one through the pool; the object counts show what is left for GC
+static FCombatBenchmarkResult BenchmarkActorPool(UWorld* World)
+{
+	static const int32 Iterations = 200;
+
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* FighterClass = GameMode && GameMode->DefaultPawnClass ? *GameMode->DefaultPawnClass : AThePunchCharacter::StaticClass();
+	const FTransform Transform(FVector(0.f, -2000.f, 200.f));
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	int32 ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+	const FCombatBenchmarkResult Spawned = FCombatBenchmarks::Measure(TEXT("Pool.SpawnActor"), Iterations, [World, FighterClass, &Transform, &SpawnParams]()
+	{
+		AActor* Fighter = World->SpawnActor<AActor>(FighterClass, Transform, SpawnParams);
+
+		if (Fighter)
+		{
+			Fighter->Destroy();
+		}
+	});
+
+	const int32 SpawnGarbage = GUObjectArray.GetObjectArrayNumMinusAvailable() - ObjectsBefore;
+
+	FActorPool Pool;
+	Pool.Prewarm(World, FighterClass, 1);
+
+	ObjectsBefore = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+	const FCombatBenchmarkResult Result = FCombatBenchmarks::Measure(TEXT("Pool.Acquire"), Iterations, [World, FighterClass, &Transform, &Pool]()
+	{
+		Pool.Release(Pool.Acquire(World, FighterClass, Transform));
+	});
+
+	const int32 PoolGarbage = GUObjectArray.GetObjectArrayNumMinusAvailable() - ObjectsBefore;
+
+	Pool.Empty();
+
+	UE_LOG(LogThePunch, Display, TEXT("Fighter respawn: SpawnActor %.1f us and %d objects for GC, pool %.1f us and %d objects for GC (%d respawns + warm up)"),
+		Spawned.NsPerOp / 1000.0, SpawnGarbage, Result.NsPerOp / 1000.0, PoolGarbage, Iterations);
+
+	return Result;
+}
+
+static struct FRegisterActorPoolBenchmark
+{
+	FRegisterActorPoolBenchmark()
+	{
+		FCombatBenchmarks::GetExtraBenchmarks().Add(&BenchmarkActorPool);
+	}
+} RegisterActorPoolBenchmark;
+
+#endif
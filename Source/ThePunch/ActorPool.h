@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UWorld;
+
+/**
+ * Parked actors per class, spawned ahead of time so a respawn or an impact effect does not
+ * run the actor constructor, component registration and asset lookups in the middle of a fight.
+ * A parked actor is hidden, has no collision and does not tick; fighters also leave the match
+ * and reset their combat state, see AThePunchCharacter::SetIsParked.
+ */
+class THEPUNCH_API FActorPool
+{
+public:
+	// spawns parked actors until Count of Class are waiting
+	void Prewarm(UWorld* World, UClass* Class, int32 Count);
+
+	/**
+	* Acquire - takes a parked actor of Class and moves it to Transform
+	* @param World world the actor lives in
+	* @param Class class of the actor, parked actors of other classes are never handed out
+	* @param Transform where the actor appears
+	* @return the actor, freshly spawned when none was parked
+	*/
+	AActor* Acquire(UWorld* World, UClass* Class, const FTransform& Transform);
+
+	template<typename ActorType>
+	ActorType* Acquire(UWorld* World, UClass* Class, const FTransform& Transform)
+	{
+		return Cast<ActorType>(Acquire(World, Class, Transform));
+	}
+
+	// parks the actor for the next Acquire of its class
+	void Release(AActor* Actor);
+
+	// destroys every parked actor
+	void Empty();
+
+	// number of parked actors of a class
+	int32 GetNumParked(UClass* Class) const;
+
+private:
+	static AActor* Spawn(UWorld* World, UClass* Class, const FTransform& Transform);
+
+	static void Park(AActor* Actor);
+
+	static void Unpark(AActor* Actor, const FTransform& Transform);
+
+	// weak, a parked actor can still be destroyed from elsewhere, e.g. when its level unloads
+	TMap<UClass*, TArray<TWeakObjectPtr<AActor>>> Parked;
+};
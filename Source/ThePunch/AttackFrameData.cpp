@@ -0,0 +1,408 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AttackFrameData.h"
+#include "ThePunch.h"
+#include "AttackStartNotifyState.h"
+#include "PunchThrowAnimNotifyState.h"
+#include "Animation/AnimMontage.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+//////////////////////////////////////////////////////////////////////////
+// FAttackFrameData
+
+// a notify exactly on a frame belongs to that frame, float noise must not push it to the next one
+static int32 SecondsToFrames(float Seconds, float TickRate)
+{
+	return FMath::Max(0, FMath::CeilToInt(Seconds * TickRate - KINDA_SMALL_NUMBER));
+}
+
+// true when a window starts before the previous one has ended; Windows are sorted by start
+static bool HasOverlap(TArray<FVector2D, TInlineAllocator<4>>& Windows)
+{
+	Windows.Sort([](const FVector2D& A, const FVector2D& B) { return A.X < B.X; });
+
+	for (int32 Index = 1; Index < Windows.Num(); ++Index)
+	{
+		if (Windows[Index].X < Windows[Index - 1].Y)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+FAttackFrameData::FAttackFrameData()
+	: Startup(0)
+	, Active(0)
+	, Recovery(0)
+	, Flags(EFrameDataFlags::NONE)
+{
+}
+
+FAttackFrameData FAttackFrameData::Analyze(const UAnimMontage* Montage, FName SectionName, float TickRate)
+{
+	FAttackFrameData FrameData;
+
+	if (Montage == NULL || Montage->GetSectionIndex(SectionName) == INDEX_NONE)
+	{
+		FrameData.Flags = EFrameDataFlags::MISSING_SECTION;
+		return FrameData;
+	}
+
+	FrameData.Timeline = FAttackTimeline::Build(Montage, SectionName);
+
+	const FAttackTimeline& Timeline = FrameData.Timeline;
+
+	// the timeline keeps the first window only, look at all of them for the flags
+	TArray<FVector2D, TInlineAllocator<4>> AttackWindows;
+	TArray<FVector2D, TInlineAllocator<4>> ThrowWindows;
+
+	for (const FAnimNotifyEvent& Event : Montage->Notifies)
+	{
+		const float Time = Event.GetTriggerTime();
+
+		if (Time < Timeline.SectionStart || Time >= Timeline.SectionEnd)
+		{
+			continue;
+		}
+
+		if (Cast<UAttackStartNotifyState>(Event.NotifyStateClass))
+		{
+			AttackWindows.Add(FVector2D(Time, Event.GetEndTriggerTime()));
+		}
+		else if (Cast<UPunchThrowAnimNotifyState>(Event.NotifyStateClass))
+		{
+			ThrowWindows.Add(FVector2D(Time, Event.GetEndTriggerTime()));
+		}
+	}
+
+	if (!Timeline.HasWindow())
+	{
+		FrameData.Flags |= EFrameDataFlags::MISSING_WINDOW;
+	}
+
+	if (Timeline.ThrowSoundTimes.Num() == 0)
+	{
+		FrameData.Flags |= EFrameDataFlags::MISSING_THROW;
+	}
+
+	if (HasOverlap(AttackWindows))
+	{
+		FrameData.Flags |= EFrameDataFlags::OVERLAPPING_WINDOWS;
+	}
+
+	if (HasOverlap(ThrowWindows))
+	{
+		FrameData.Flags |= EFrameDataFlags::OVERLAPPING_THROWS;
+	}
+
+	if (Timeline.HasWindow() && Timeline.WindowEnd > Timeline.SectionEnd + KINDA_SMALL_NUMBER)
+	{
+		FrameData.Flags |= EFrameDataFlags::WINDOW_PAST_SECTION;
+	}
+
+	const int32 Total = SecondsToFrames(Timeline.SectionEnd - Timeline.SectionStart, TickRate);
+
+	if (Timeline.HasWindow())
+	{
+		// a window past the section is cut where the next section takes over
+		const int32 WindowEndFrame = FMath::Min(SecondsToFrames(Timeline.WindowEnd - Timeline.SectionStart, TickRate), Total);
+
+		FrameData.Startup = FMath::Min(SecondsToFrames(Timeline.WindowStart - Timeline.SectionStart, TickRate), WindowEndFrame);
+		FrameData.Active = WindowEndFrame - FrameData.Startup;
+		FrameData.Recovery = Total - WindowEndFrame;
+	}
+	else
+	{
+		FrameData.Recovery = Total;
+	}
+
+	return FrameData;
+}
+
+FString FAttackFrameData::GetFlagNames() const
+{
+	static const TCHAR* FlagNames[] = { TEXT("MISSING_SECTION"), TEXT("MISSING_WINDOW"), TEXT("MISSING_THROW"), TEXT("OVERLAPPING_WINDOWS"), TEXT("OVERLAPPING_THROWS"), TEXT("WINDOW_PAST_SECTION") };
+
+	FString Names;
+
+	for (int32 Bit = 0; Bit < (int32)ARRAY_COUNT(FlagNames); ++Bit)
+	{
+		if (EnumHasAnyFlags(Flags, (EFrameDataFlags)(1 << Bit)))
+		{
+			if (!Names.IsEmpty())
+			{
+				Names += TEXT(" ");
+			}
+
+			Names += FlagNames[Bit];
+		}
+	}
+
+	return Names;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FAttackFrameDataTable
+
+FAttackFrameDataTable::FAttackFrameDataTable()
+	: TickRate(60.f)
+{
+	Load();
+}
+
+FAttackFrameDataTable& FAttackFrameDataTable::Get()
+{
+	static FAttackFrameDataTable Table;
+	return Table;
+}
+
+FString FAttackFrameDataTable::GetPath()
+{
+	// under Content so packaging stages it, see DirectoriesToAlwaysStageAsUFS in DefaultGame.ini
+	return FPaths::ProjectContentDir() / TEXT("FrameData") / TEXT("AttackFrameData.json");
+}
+
+const FAttackFrameData* FAttackFrameDataTable::Find(const UAnimMontage* Montage, FName SectionName) const
+{
+	if (Montage == NULL)
+	{
+		return NULL;
+	}
+
+	const UPackage* Package = Montage->GetOutermost();
+	const FGuid* PackageGuid = PackageGuids.Find(Package->GetFName());
+
+	if (PackageGuid == NULL)
+	{
+		return NULL;
+	}
+
+	// a montage saved, or edited in the editor, after the analysis may have moved its notifies;
+	// cooking saves the packages again under new guids, but cooked montages never change
+	if (!FPlatformProperties::RequiresCookedData() && (*PackageGuid != Package->GetGuid() || Package->IsDirty()))
+	{
+		return NULL;
+	}
+
+	const FSectionKey Key = { Package->GetFName(), SectionName };
+
+	return Sections.Find(Key);
+}
+
+const FAttackFrameData* FAttackFrameDataTable::FindOrAnalyze(const UAnimMontage* Montage, FName SectionName)
+{
+	if (const FAttackFrameData* FrameData = Find(Montage, SectionName))
+	{
+		return FrameData;
+	}
+
+	if (Montage == NULL)
+	{
+		return NULL;
+	}
+
+	const UPackage* Package = Montage->GetOutermost();
+	const FName PackageName = Package->GetFName();
+
+	if (!FPlatformProperties::RequiresCookedData() && Package->IsDirty())
+	{
+		return NULL;
+	}
+
+	const FGuid* PackageGuid = PackageGuids.Find(PackageName);
+
+	// the file analyzed an older version of the montage, its sections are analyzed again here
+	if (PackageGuid && *PackageGuid != Package->GetGuid() && !FPlatformProperties::RequiresCookedData())
+	{
+		if (!StalePackages.Contains(PackageName))
+		{
+			UE_LOG(LogThePunch, Warning, TEXT("%s is stale for %s, run -run=ThePunchFrameData to update it"), *GetPath(), *PackageName.ToString());
+			StalePackages.Add(PackageName);
+		}
+
+		SetMontage(PackageName, Package->GetGuid(), TMap<FName, FAttackFrameData>());
+	}
+	else if (PackageGuid == NULL)
+	{
+		PackageGuids.Add(PackageName, Package->GetGuid());
+	}
+
+	const FSectionKey Key = { PackageName, SectionName };
+
+	return &Sections.Add(Key, FAttackFrameData::Analyze(Montage, SectionName, TickRate));
+}
+
+void FAttackFrameDataTable::SetMontage(FName PackageName, const FGuid& PackageGuid, const TMap<FName, FAttackFrameData>& MontageSections)
+{
+	for (auto It = Sections.CreateIterator(); It; ++It)
+	{
+		if (It.Key().PackageName == PackageName)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (const TPair<FName, FAttackFrameData>& Section : MontageSections)
+	{
+		const FSectionKey Key = { PackageName, Section.Key };
+		Sections.Add(Key, Section.Value);
+	}
+
+	PackageGuids.Add(PackageName, PackageGuid);
+}
+
+FGuid FAttackFrameDataTable::GetPackageGuid(FName PackageName) const
+{
+	const FGuid* PackageGuid = PackageGuids.Find(PackageName);
+
+	return PackageGuid ? *PackageGuid : FGuid();
+}
+
+void FAttackFrameDataTable::RemoveMontagesExcept(const TSet<FName>& PackageNames)
+{
+	for (auto It = Sections.CreateIterator(); It; ++It)
+	{
+		if (!PackageNames.Contains(It.Key().PackageName))
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for (auto It = PackageGuids.CreateIterator(); It; ++It)
+	{
+		if (!PackageNames.Contains(It.Key()))
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FAttackFrameDataTable::SetTickRate(float NewTickRate)
+{
+	// frame counts of another rate are worthless, everything is analyzed again
+	if (NewTickRate != TickRate)
+	{
+		Sections.Reset();
+		PackageGuids.Reset();
+		TickRate = NewTickRate;
+	}
+}
+
+bool FAttackFrameDataTable::Load()
+{
+	FString Text;
+	TSharedPtr<FJsonObject> Root;
+
+	if (!FFileHelper::LoadFileToString(Text, *GetPath()) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Root) || !Root.IsValid())
+	{
+		UE_LOG(LogThePunch, Warning, TEXT("No attack frame data in %s, run -run=ThePunchFrameData; sections are analyzed on first use until then"), *GetPath());
+		return false;
+	}
+
+	Sections.Reset();
+	PackageGuids.Reset();
+	TickRate = Root->GetNumberField(TEXT("TickRate"));
+
+	const TSharedPtr<FJsonObject>* Montages = NULL;
+
+	if (!Root->TryGetObjectField(TEXT("Montages"), Montages))
+	{
+		return false;
+	}
+
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Montage : (*Montages)->Values)
+	{
+		const TSharedPtr<FJsonObject> MontageObject = Montage.Value->AsObject();
+		const FName PackageName(*Montage.Key);
+
+		FGuid PackageGuid;
+		FGuid::Parse(MontageObject->GetStringField(TEXT("Guid")), PackageGuid);
+		PackageGuids.Add(PackageName, PackageGuid);
+
+		for (const TPair<FString, TSharedPtr<FJsonValue>>& Section : MontageObject->GetObjectField(TEXT("Sections"))->Values)
+		{
+			const TSharedPtr<FJsonObject> SectionObject = Section.Value->AsObject();
+
+			FAttackFrameData FrameData;
+			FrameData.Startup = (int32)SectionObject->GetNumberField(TEXT("Startup"));
+			FrameData.Active = (int32)SectionObject->GetNumberField(TEXT("Active"));
+			FrameData.Recovery = (int32)SectionObject->GetNumberField(TEXT("Recovery"));
+			FrameData.Flags = (EFrameDataFlags)(uint8)SectionObject->GetNumberField(TEXT("Flags"));
+			FrameData.Timeline.SectionStart = SectionObject->GetNumberField(TEXT("SectionStart"));
+			FrameData.Timeline.SectionEnd = SectionObject->GetNumberField(TEXT("SectionEnd"));
+			FrameData.Timeline.WindowStart = SectionObject->GetNumberField(TEXT("WindowStart"));
+			FrameData.Timeline.WindowEnd = SectionObject->GetNumberField(TEXT("WindowEnd"));
+
+			for (const TSharedPtr<FJsonValue>& Time : SectionObject->GetArrayField(TEXT("ThrowSoundTimes")))
+			{
+				FrameData.Timeline.ThrowSoundTimes.Add(Time->AsNumber());
+			}
+
+			const FSectionKey Key = { PackageName, FName(*Section.Key) };
+			Sections.Add(Key, FrameData);
+		}
+	}
+
+	if (PackageGuids.Num() == 0)
+	{
+		UE_LOG(LogThePunch, Warning, TEXT("%s has no montages, run -run=ThePunchFrameData; sections are analyzed on first use until then"), *GetPath());
+	}
+
+	return true;
+}
+
+bool FAttackFrameDataTable::Save() const
+{
+	TSharedPtr<FJsonObject> Montages = MakeShareable(new FJsonObject());
+
+	for (const TPair<FName, FGuid>& Package : PackageGuids)
+	{
+		TSharedPtr<FJsonObject> MontageObject = MakeShareable(new FJsonObject());
+		MontageObject->SetStringField(TEXT("Guid"), Package.Value.ToString());
+		MontageObject->SetObjectField(TEXT("Sections"), MakeShareable(new FJsonObject()));
+		Montages->SetObjectField(Package.Key.ToString(), MontageObject);
+	}
+
+	for (const TPair<FSectionKey, FAttackFrameData>& Section : Sections)
+	{
+		const FAttackFrameData& FrameData = Section.Value;
+
+		TSharedPtr<FJsonObject> SectionObject = MakeShareable(new FJsonObject());
+		SectionObject->SetNumberField(TEXT("Startup"), FrameData.Startup);
+		SectionObject->SetNumberField(TEXT("Active"), FrameData.Active);
+		SectionObject->SetNumberField(TEXT("Recovery"), FrameData.Recovery);
+		SectionObject->SetNumberField(TEXT("Flags"), (uint8)FrameData.Flags);
+		SectionObject->SetStringField(TEXT("Problems"), FrameData.GetFlagNames());
+		SectionObject->SetNumberField(TEXT("SectionStart"), FrameData.Timeline.SectionStart);
+		SectionObject->SetNumberField(TEXT("SectionEnd"), FrameData.Timeline.SectionEnd);
+		SectionObject->SetNumberField(TEXT("WindowStart"), FrameData.Timeline.WindowStart);
+		SectionObject->SetNumberField(TEXT("WindowEnd"), FrameData.Timeline.WindowEnd);
+
+		TArray<TSharedPtr<FJsonValue>> ThrowSoundTimes;
+
+		for (const float Time : FrameData.Timeline.ThrowSoundTimes)
+		{
+			ThrowSoundTimes.Add(MakeShareable(new FJsonValueNumber(Time)));
+		}
+
+		SectionObject->SetArrayField(TEXT("ThrowSoundTimes"), ThrowSoundTimes);
+
+		Montages->GetObjectField(Section.Key.PackageName.ToString())->GetObjectField(TEXT("Sections"))->SetObjectField(Section.Key.SectionName.ToString(), SectionObject);
+	}
+
+	TSharedPtr<FJsonObject> Root = MakeShareable(new FJsonObject());
+	Root->SetNumberField(TEXT("TickRate"), TickRate);
+	Root->SetObjectField(TEXT("Montages"), Montages);
+
+	FString Text;
+	FJsonSerializer::Serialize(Root.ToSharedRef(), TJsonWriterFactory<>::Create(&Text));
+
+	return FFileHelper::SaveStringToFile(Text, *GetPath());
+}
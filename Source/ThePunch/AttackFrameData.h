@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AttackScript.h"
+
+class UAnimMontage;
+
+/** problems found in a section's notifies, a section can have several */
+enum class EFrameDataFlags : uint8
+{
+	NONE = 0,
+	// the section does not exist in the montage
+	MISSING_SECTION = 1 << 0,
+	// no UAttackStartNotifyState starts in the section
+	MISSING_WINDOW = 1 << 1,
+	// no punch throw notify starts in the section, the attack swings silently
+	MISSING_THROW = 1 << 2,
+	// two attack windows of the section overlap, only the first one is used
+	OVERLAPPING_WINDOWS = 1 << 3,
+	// two throw windows of the section overlap, the sound is cut off
+	OVERLAPPING_THROWS = 1 << 4,
+	// the attack window runs on into the next section
+	WINDOW_PAST_SECTION = 1 << 5
+};
+
+ENUM_CLASS_FLAGS(EFrameDataFlags);
+
+/** Startup, active and recovery frames of one start_N section at a fixed tick rate */
+struct THEPUNCH_API FAttackFrameData
+{
+	FAttackFrameData();
+
+	/**
+	* Analyze - reads the attack and throw windows of a montage section and counts its frames
+	* @param Montage the attack montage
+	* @param SectionName the start_N section
+	* @param TickRate frames per second the frames are counted at
+	* @return the frame data, Flags tells what is missing or overlapping
+	*/
+	static FAttackFrameData Analyze(const UAnimMontage* Montage, FName SectionName, float TickRate);
+
+	// names of the flags set in Flags, e.g. "MISSING_WINDOW OVERLAPPING_THROWS"
+	FString GetFlagNames() const;
+
+	// window and throw times in montage time, the attack scripts start from these
+	FAttackTimeline Timeline;
+
+	// frames before the hitboxes go live
+	int32 Startup;
+
+	// frames the hitboxes are live
+	int32 Active;
+
+	// frames from the end of the window to the end of the section
+	int32 Recovery;
+
+	EFrameDataFlags Flags;
+};
+
+/**
+ * Frame data of every attack section, written by the ThePunchFrameData commandlet to
+ * Content/FrameData/AttackFrameData.json and loaded on first use. Lookups are a hash of package and
+ * section name. A section missing from the file, or of a montage saved since the analysis, is
+ * analyzed on its first lookup and kept for the session; loading warns when the file is empty,
+ * and the first lookup of a stale montage warns, so the commandlet gets run again.
+ */
+class THEPUNCH_API FAttackFrameDataTable
+{
+public:
+	static FAttackFrameDataTable& Get();
+
+	/**
+	* Find - the frame data of a section, game thread only
+	* @param Montage the attack montage
+	* @param SectionName the start_N section
+	* @return null when the section was not analyzed or the montage changed since
+	*/
+	const FAttackFrameData* Find(const UAnimMontage* Montage, FName SectionName) const;
+
+	/**
+	* FindOrAnalyze - the frame data of a section, analyzed and kept when the file does not have it, game thread only
+	* @param Montage the attack montage
+	* @param SectionName the start_N section
+	* @return null only for a montage being edited, its notifies may still move
+	*/
+	const FAttackFrameData* FindOrAnalyze(const UAnimMontage* Montage, FName SectionName);
+
+	// replaces the frame data of a montage package, used by the commandlet
+	void SetMontage(FName PackageName, const FGuid& PackageGuid, const TMap<FName, FAttackFrameData>& Sections);
+
+	// package guid the montage had when it was analyzed, invalid when it was never analyzed
+	FGuid GetPackageGuid(FName PackageName) const;
+
+	// drops montages that are no longer referenced by the data table
+	void RemoveMontagesExcept(const TSet<FName>& PackageNames);
+
+	float GetTickRate() const { return TickRate; }
+
+	void SetTickRate(float NewTickRate);
+
+	bool Load();
+
+	bool Save() const;
+
+	static FString GetPath();
+
+private:
+	FAttackFrameDataTable();
+
+	struct FSectionKey
+	{
+		FName PackageName;
+
+		FName SectionName;
+
+		bool operator==(const FSectionKey& Other) const
+		{
+			return PackageName == Other.PackageName && SectionName == Other.SectionName;
+		}
+
+		friend uint32 GetTypeHash(const FSectionKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.PackageName), GetTypeHash(Key.SectionName));
+		}
+	};
+
+	TMap<FSectionKey, FAttackFrameData> Sections;
+
+	TMap<FName, FGuid> PackageGuids;
+
+	// montages the stale warning was given for
+	TSet<FName> StalePackages;
+
+	float TickRate;
+};
@@ -0,0 +1,352 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AttackScript.h"
+#include "AttackFrameData.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchGameState.h"
+#include "CombatBenchmarks.h"
+#include "AttackStartNotifyState.h"
+#include "PunchAnimNotify.h"
+#include "PunchThrowAnimNotifyState.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Attack Scripts"), STAT_UpdateAttackScripts, STATGROUP_ThePunch);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Running Attack Scripts"), STAT_RunningAttackScripts, STATGROUP_ThePunch);
+
+//////////////////////////////////////////////////////////////////////////
+// FAttackTimeline
+
+FAttackTimeline::FAttackTimeline()
+	: SectionStart(0.f)
+	, SectionEnd(0.f)
+	, WindowStart(0.f)
+	, WindowEnd(0.f)
+{
+}
+
+FAttackTimeline FAttackTimeline::Build(const UAnimMontage* Montage, FName SectionName)
+{
+	FAttackTimeline Timeline;
+
+	const int32 SectionIndex = Montage ? Montage->GetSectionIndex(SectionName) : INDEX_NONE;
+
+	if (SectionIndex == INDEX_NONE)
+	{
+		return Timeline;
+	}
+
+	Montage->GetSectionStartAndEndTime(SectionIndex, Timeline.SectionStart, Timeline.SectionEnd);
+
+	for (const FAnimNotifyEvent& Event : Montage->Notifies)
+	{
+		const float Time = Event.GetTriggerTime();
+
+		if (Time < Timeline.SectionStart || Time >= Timeline.SectionEnd)
+		{
+			continue;
+		}
+
+		if (Cast<UAttackStartNotifyState>(Event.NotifyStateClass))
+		{
+			// a section has one window, the first one wins
+			if (!Timeline.HasWindow())
+			{
+				Timeline.WindowStart = Time;
+				Timeline.WindowEnd = Event.GetEndTriggerTime();
+			}
+		}
+		else if (Cast<UPunchThrowAnimNotifyState>(Event.NotifyStateClass) || Cast<UPunchAnimNotify>(Event.Notify))
+		{
+			Timeline.ThrowSoundTimes.Add(Time);
+		}
+	}
+
+	Timeline.ThrowSoundTimes.Sort();
+
+	return Timeline;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FAttackScript
+
+FAttackScript FAttackScript::Build(const FAttackTimeline& Timeline, EAttackType AttackType)
+{
+	FAttackScript Script;
+
+	Script.Steps.Add({ EAttackStep::WAIT_UNTIL, Timeline.WindowStart });
+	Script.Steps.Add({ EAttackStep::OPEN_WINDOW, Timeline.WindowStart });
+
+	if (AttackType == EAttackType::MELEE_KICK)
+	{
+		Script.Steps.Add({ EAttackStep::LOCK_INPUT, Timeline.WindowStart });
+	}
+
+	Script.Steps.Add({ EAttackStep::AWAIT_HIT_OR_TIME, Timeline.WindowEnd });
+	Script.Steps.Add({ EAttackStep::CLOSE_WINDOW, Timeline.WindowEnd });
+
+	Script.ThrowSoundTimes = Timeline.ThrowSoundTimes;
+
+	return Script;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FAttackScheduler
+
+FAttackScheduler::FAttackScheduler()
+{
+}
+
+const FAttackScript* FAttackScheduler::FindScript(UAnimMontage* Montage, FName SectionName, EAttackType AttackType)
+{
+	const FScriptKey Key = { Montage, SectionName, AttackType };
+
+	if (const TUniquePtr<FAttackScript>* Found = Scripts.Find(Key))
+	{
+		return Found->Get();
+	}
+
+	// the frame data table analyzes sections it does not have yet, only a montage being edited is built here
+	const FAttackFrameData* FrameData = FAttackFrameDataTable::Get().FindOrAnalyze(Montage, SectionName);
+	const FAttackTimeline Timeline = FrameData ? FrameData->Timeline : FAttackTimeline::Build(Montage, SectionName);
+
+	TUniquePtr<FAttackScript>& Script = Scripts.Add(Key);
+
+	if (Timeline.HasWindow())
+	{
+		Script = MakeUnique<FAttackScript>(FAttackScript::Build(Timeline, AttackType));
+	}
+	else
+	{
+		UE_LOG(LogThePunch, Verbose, TEXT("%s section %s has no attack window, its notifies drive the attack"), *GetNameSafe(Montage), *SectionName.ToString());
+	}
+
+	return Script.Get();
+}
+
+void FAttackScheduler::ClearScripts()
+{
+	// running attacks point into the cache
+	while (Running.Num() > 0)
+	{
+		Stop(Running.Last().Fighter);
+	}
+
+	Scripts.Reset();
+}
+
+int32 FAttackScheduler::FindRunning(const AThePunchCharacter* Fighter) const
+{
+	return Running.IndexOfByPredicate([Fighter](const FRunningAttack& Attack) { return Attack.Fighter == Fighter; });
+}
+
+bool FAttackScheduler::Start(AThePunchCharacter* Fighter, UAnimMontage* Montage, FName SectionName, EAttackType AttackType)
+{
+	Stop(Fighter);
+
+	const FAttackScript* Script = FindScript(Montage, SectionName, AttackType);
+
+	// the notifies drive this section, they must not see the fighter as scripted
+	if (Script == NULL)
+	{
+		Fighter->SetIsAttackScripted(false);
+		return false;
+	}
+
+	FRunningAttack& Attack = Running[Running.AddUninitialized()];
+	Attack.Fighter = Fighter;
+	Attack.Montage = Montage;
+	Attack.Script = Script;
+	Attack.StepIndex = 0;
+	Attack.SoundIndex = 0;
+	Attack.bWindowOpen = false;
+	Attack.bHit = false;
+
+	Fighter->SetIsAttackScripted(true);
+
+	return true;
+}
+
+void FAttackScheduler::NotifyHit(AThePunchCharacter* Fighter)
+{
+	const int32 Index = FindRunning(Fighter);
+
+	if (Index != INDEX_NONE)
+	{
+		Running[Index].bHit = true;
+	}
+}
+
+void FAttackScheduler::Stop(AThePunchCharacter* Fighter)
+{
+	const int32 Index = FindRunning(Fighter);
+
+	if (Index != INDEX_NONE)
+	{
+		Finish(Running[Index]);
+		Running.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+void FAttackScheduler::Finish(FRunningAttack& Attack)
+{
+	if (Attack.bWindowOpen)
+	{
+		Attack.Fighter->AttackEnd();
+		Attack.Fighter->SetIsKeyboardEnabled(true);
+
+		Attack.bWindowOpen = false;
+	}
+
+	Attack.Fighter->SetIsAttackScripted(false);
+}
+
+void FAttackScheduler::Resume(AThePunchCharacter* Fighter, float Position)
+{
+	const int32 Index = FindRunning(Fighter);
+
+	if (Index != INDEX_NONE)
+	{
+		Resume(Running[Index], Position);
+	}
+}
+
+bool FAttackScheduler::Resume(FRunningAttack& Attack, float Position)
+{
+	AThePunchCharacter* Fighter = Attack.Fighter;
+	const FAttackScript& Script = *Attack.Script;
+
+	while (Attack.SoundIndex < Script.ThrowSoundTimes.Num() && Position >= Script.ThrowSoundTimes[Attack.SoundIndex])
+	{
+		Fighter->PlayThrowSound();
+		++Attack.SoundIndex;
+	}
+
+	while (Attack.StepIndex < Script.Steps.Num())
+	{
+		const FAttackStep& Step = Script.Steps[Attack.StepIndex];
+
+		switch (Step.Step)
+		{
+		case EAttackStep::WAIT_UNTIL:
+			if (Position < Step.Time)
+			{
+				return false;
+			}
+			break;
+		case EAttackStep::OPEN_WINDOW:
+			Fighter->AttackStart();
+			Attack.bWindowOpen = true;
+			break;
+		case EAttackStep::LOCK_INPUT:
+			Fighter->SetIsKeyboardEnabled(false);
+			break;
+		case EAttackStep::AWAIT_HIT_OR_TIME:
+			if (!Attack.bHit && Position < Step.Time)
+			{
+				return false;
+			}
+			break;
+		case EAttackStep::CLOSE_WINDOW:
+			Fighter->AttackEnd();
+			Fighter->SetIsKeyboardEnabled(true);
+			Attack.bWindowOpen = false;
+			break;
+		}
+
+		++Attack.StepIndex;
+	}
+
+	// the throw sound can come after the window
+	return Attack.SoundIndex >= Script.ThrowSoundTimes.Num();
+}
+
+void FAttackScheduler::Update()
+{
+	SCOPE_CYCLE_COUNTER(STAT_UpdateAttackScripts);
+	SET_DWORD_STAT(STAT_RunningAttackScripts, Running.Num());
+
+	for (int32 Index = Running.Num() - 1; Index >= 0; --Index)
+	{
+		FRunningAttack& Attack = Running[Index];
+
+		UAnimInstance* AnimInstance = Attack.Fighter->GetMesh()->GetAnimInstance();
+
+		// an interrupted or blended out montage ends the attack, like the notify state end did
+		if (AnimInstance == NULL || !AnimInstance->Montage_IsPlaying(Attack.Montage))
+		{
+			Finish(Attack);
+			Running.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		// a finished script stays in the list until its montage ends, so the rest of the
+		// section's notifies stay quiet and the fighter is unscripted with the montage
+		Resume(Attack, AnimInstance->Montage_GetPosition(Attack.Montage));
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+// one scheduler pass over hundreds of attacks in flight, the per-frame cost of scripted combat
+static FCombatBenchmarkResult BenchmarkAttackScripts(UWorld* World)
+{
+	static const int32 NumAttacks = 256;
+
+	AThePunchGameState* GameState = World->GetGameState<AThePunchGameState>();
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* FighterClass = GameMode && GameMode->DefaultPawnClass ? *GameMode->DefaultPawnClass : AThePunchCharacter::StaticClass();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TArray<AThePunchCharacter*> Fighters;
+
+	for (int32 Index = 0; Index < NumAttacks && GameState; ++Index)
+	{
+		AThePunchCharacter* Fighter = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector((Index % 16) * 300.f, 2000.f + (Index / 16) * 300.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+
+		if (Fighter)
+		{
+			Fighter->AttackInput(Index % 2 ? EAttackType::MELEE_KICK : EAttackType::MELEE_FIST);
+			Fighters.Add(Fighter);
+		}
+	}
+
+	const int32 NumRunning = GameState ? GameState->GetAttackScheduler().GetNumRunning() : 0;
+
+	if (NumRunning < NumAttacks)
+	{
+		UE_LOG(LogThePunch, Warning, TEXT("Only %d of %d attacks are scripted, the rest have no montage or no attack window"), NumRunning, NumAttacks);
+	}
+
+	// the world does not tick while measuring, every pass polls the same montage times
+	const FCombatBenchmarkResult Result = FCombatBenchmarks::Measure(TEXT("AttackScripts.Update256"), 1000, [GameState]()
+	{
+		if (GameState)
+		{
+			GameState->GetAttackScheduler().Update();
+		}
+	});
+
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		Fighter->Destroy();
+	}
+
+	return Result;
+}
+
+static struct FRegisterAttackScriptBenchmark
+{
+	FRegisterAttackScriptBenchmark()
+	{
+		FCombatBenchmarks::GetExtraBenchmarks().Add(&BenchmarkAttackScripts);
+	}
+} RegisterAttackScriptBenchmark;
+
+#endif
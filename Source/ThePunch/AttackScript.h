@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AThePunchCharacter;
+class UAnimMontage;
+enum class EAttackType : uint8;
+
+/** Attack window and throw sound times of one montage section, read from its notifies */
+struct THEPUNCH_API FAttackTimeline
+{
+	FAttackTimeline();
+
+	/**
+	* Build - collects the UAttackStartNotifyState window and the punch throw notifies
+	* that start inside a montage section
+	* @param Montage the attack montage
+	* @param SectionName the start_N section that is played
+	* @return the timeline in montage time; without a window HasWindow is false
+	*/
+	static FAttackTimeline Build(const UAnimMontage* Montage, FName SectionName);
+
+	bool HasWindow() const { return WindowEnd > WindowStart; }
+
+	float SectionStart;
+
+	float SectionEnd;
+
+	// hitboxes are live from WindowStart to WindowEnd
+	float WindowStart;
+
+	float WindowEnd;
+
+	// times the throw sound is played
+	TArray<float, TInlineAllocator<2>> ThrowSoundTimes;
+};
+
+enum class EAttackStep : uint8
+{
+	// waits until the montage reaches the step time
+	WAIT_UNTIL,
+	// AttackStart, the hitboxes go live
+	OPEN_WINDOW,
+	// the keyboard stops responding, kicks only
+	LOCK_INPUT,
+	// waits for the first hit, or until the montage reaches the step time
+	AWAIT_HIT_OR_TIME,
+	// AttackEnd and the keyboard responds again
+	CLOSE_WINDOW
+};
+
+struct FAttackStep
+{
+	EAttackStep Step;
+
+	float Time;
+};
+
+/**
+ * An attack as a straight line of steps instead of notify callbacks, e.g. for a kick:
+ *   wait until the window opens, open it, lock input, await a hit or the window end, close it
+ * Throw sounds run beside the steps and never wait for them.
+ */
+struct THEPUNCH_API FAttackScript
+{
+	static FAttackScript Build(const FAttackTimeline& Timeline, EAttackType AttackType);
+
+	TArray<FAttackStep, TInlineAllocator<5>> Steps;
+
+	TArray<float, TInlineAllocator<2>> ThrowSoundTimes;
+};
+
+/**
+ * Runs the attack scripts of every fighter in the world. Update resumes all of them in one
+ * pass per frame, driven by the montage time, so attacks cost no notify callbacks.
+ * Sections without an attack window in their notifies are left to the notifies.
+ */
+class THEPUNCH_API FAttackScheduler
+{
+public:
+	FAttackScheduler();
+
+	/**
+	* Start - runs the script of a montage section that was just played, a running
+	* attack of the fighter is ended first
+	* @param Fighter the attacker
+	* @param Montage the attack montage
+	* @param SectionName the section that is played
+	* @param AttackType fist or kick
+	* @return false when the section has no attack window, its notifies drive the attack then
+	*/
+	bool Start(AThePunchCharacter* Fighter, UAnimMontage* Montage, FName SectionName, EAttackType AttackType);
+
+	// resumes a fighter awaiting a hit on the next update
+	void NotifyHit(AThePunchCharacter* Fighter);
+
+	// ends the fighter's attack, closing its window
+	void Stop(AThePunchCharacter* Fighter);
+
+	// resumes every running attack whose montage reached its next step, call once per frame
+	void Update();
+
+	// resumes the fighter's attack at a montage position, Update does this with the time its montage reached
+	void Resume(AThePunchCharacter* Fighter, float Position);
+
+	// number of attack montages playing with a script, finished scripts included
+	int32 GetNumRunning() const { return Running.Num(); }
+
+	// forgets the scripts built from montages, they are rebuilt on the next attack
+	void ClearScripts();
+
+private:
+	struct FScriptKey
+	{
+		const UAnimMontage* Montage;
+
+		FName SectionName;
+
+		EAttackType AttackType;
+
+		bool operator==(const FScriptKey& Other) const
+		{
+			return Montage == Other.Montage && SectionName == Other.SectionName && AttackType == Other.AttackType;
+		}
+
+		friend uint32 GetTypeHash(const FScriptKey& Key)
+		{
+			return HashCombine(HashCombine(PointerHash(Key.Montage), GetTypeHash(Key.SectionName)), (uint32)Key.AttackType);
+		}
+	};
+
+	struct FRunningAttack
+	{
+		AThePunchCharacter* Fighter;
+
+		UAnimMontage* Montage;
+
+		const FAttackScript* Script;
+
+		int32 StepIndex;
+
+		int32 SoundIndex;
+
+		bool bWindowOpen;
+
+		bool bHit;
+	};
+
+	// returns the cached script of a section, builds it on first use
+	const FAttackScript* FindScript(UAnimMontage* Montage, FName SectionName, EAttackType AttackType);
+
+	// runs the steps that are due, returns true when the script is done
+	bool Resume(FRunningAttack& Attack, float Position);
+
+	// closes the window of an attack that ended early
+	void Finish(FRunningAttack& Attack);
+
+	int32 FindRunning(const AThePunchCharacter* Fighter) const;
+
+	TArray<FRunningAttack> Running;
+
+	// scripts by montage, section and attack type; null when the section has no window
+	TMap<FScriptKey, TUniquePtr<FAttackScript>> Scripts;
+};
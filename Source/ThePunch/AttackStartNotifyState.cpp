@@ -9,48 +9,45 @@
 ///The exact time the attack animation is fired
 void UAttackStartNotifyState::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 4.5f, FColor::Magenta, __FUNCTION__);
-
 	// check if the mesh is empty
 	if (MeshComp != NULL && MeshComp->GetOwner() != NULL)
 	{
 		AThePunchCharacter* player = Cast<AThePunchCharacter>(MeshComp->GetOwner());
 
-		if (player != NULL)
+		// attack scripts open the window themselves, see FAttackScheduler
+		if (player != NULL && !player->IsAttackScripted())
 		{
-			player->AttackStart();
-		}
-	}
-
-}
+			if (player->IsLogEnabled(ELogLevel::TRACE))
+			{
+				player->Log(ELogLevel::TRACE, ANSI_TO_TCHAR(__FUNCTION__));
+			}
 
-void UAttackStartNotifyState::NotifyTick(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration)
-{
-	AThePunchCharacter* player = Cast<AThePunchCharacter>(MeshComp->GetOwner());
+			player->AttackStart();
 
-	if (MeshComp != NULL && MeshComp->GetOwner() != NULL)
-	{
-		if (player != NULL)
-		{
+			// kicks lock the keyboard for the whole window
 			if (player->GetCurrentAttack() == EAttackType::MELEE_KICK)
 			{
 				player->SetIsKeyboardEnabled(false);
 			}
 		}
 	}
+
 }
 
 ///The exact time the attack animation ended
 void UAttackStartNotifyState::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 4.5f, FColor::Magenta, __FUNCTION__);
-
 	if (MeshComp != NULL && MeshComp->GetOwner() != NULL)
 	{
 		AThePunchCharacter* player = Cast < AThePunchCharacter>(MeshComp->GetOwner());
 
-		if (player != NULL)
+		if (player != NULL && !player->IsAttackScripted())
 		{
+			if (player->IsLogEnabled(ELogLevel::TRACE))
+			{
+				player->Log(ELogLevel::TRACE, ANSI_TO_TCHAR(__FUNCTION__));
+			}
+
 			player->AttackEnd();
 
 			player->SetIsKeyboardEnabled(true);
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatAssetSet.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchGameState.h"
+#include "CombatBenchmarks.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/DataTable.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "Misc/CommandLine.h"
+#include "UObject/UObjectArray.h"
+
+void UCombatAssetSet::Gather(const AThePunchCharacter* Fighter)
+{
+	if (Fighter == NULL)
+	{
+		return;
+	}
+
+	TArray<UObject*> FighterAssets;
+	Fighter->GetCombatAssets(FighterAssets);
+
+	for (UObject* Asset : FighterAssets)
+	{
+		if (Asset)
+		{
+			Assets.AddUnique(Asset);
+		}
+	}
+
+	// the rows are only resolved when an attack starts, hold their montages as well
+	const UDataTable* Table = Fighter->GetPlayerAttackDataTable();
+
+	if (Table)
+	{
+		static const FString ContextString(TEXT("Combat Asset Set"));
+
+		for (const FName& Row : Table->GetRowNames())
+		{
+			const FPlayerAttackMontage* AttackMontage = Table->FindRow<FPlayerAttackMontage>(Row, ContextString, false);
+
+			if (AttackMontage && AttackMontage->Montage)
+			{
+				Assets.AddUnique(AttackMontage->Montage);
+			}
+		}
+	}
+
+	// the skeleton, physics asset and materials come with the mesh into the cluster
+	const USkeletalMeshComponent* MeshComponent = Fighter->GetMesh();
+
+	if (MeshComponent && MeshComponent->SkeletalMesh)
+	{
+		Assets.AddUnique(MeshComponent->SkeletalMesh);
+	}
+}
+
+void UCombatAssetSet::MakeResident()
+{
+	if (IsRooted())
+	{
+		return;
+	}
+
+	AddToRoot();
+
+	// the editor keeps assets editable, a cluster there would go stale on the first change;
+	// -NoCombatCluster keeps the assets rooted but unclustered, for A/B runs of a whole match
+	if (!GIsEditor && Assets.Num() > 0 && !FParse::Param(FCommandLine::Get(), TEXT("NoCombatCluster")))
+	{
+		CreateCluster();
+	}
+
+	UE_LOG(LogThePunch, Log, TEXT("%d combat assets resident for the match%s"), Assets.Num(), HasAnyInternalFlags(EInternalObjectFlags::ClusterRoot) ? TEXT(" in a GC cluster") : TEXT(""));
+}
+
+void UCombatAssetSet::Release()
+{
+	if (IsRooted())
+	{
+		RemoveFromRoot();
+	}
+}
+
+bool UCombatAssetSet::CanBeClusterRoot() const
+{
+	return true;
+}
+
+#if !UE_BUILD_SHIPPING
+
+// a full reachability pass with Count fighters in the world, the numbers a crowded match pays per GC;
+// the unclustered run dissolves the combat asset cluster for the measurement and builds it again after
+static FCombatBenchmarkResult BenchmarkGarbageCollection(UWorld* World, int32 Count, bool bClustered)
+{
+	static const int32 Iterations = 10;
+	static const float Spacing = 200.f;
+
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* FighterClass = GameMode && GameMode->DefaultPawnClass ? *GameMode->DefaultPawnClass : AThePunchCharacter::StaticClass();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// a square away from the benchmark pair so nothing overlaps them
+	const int32 Columns = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count)));
+	TArray<AActor*> Fighters;
+	Fighters.Reserve(Count);
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector Location(5000.f + (Index % Columns) * Spacing, (Index / Columns) * Spacing, 200.f);
+		AActor* Fighter = World->SpawnActor<AActor>(FighterClass, FTransform(Location), SpawnParams);
+
+		if (Fighter)
+		{
+			Fighters.Add(Fighter);
+		}
+	}
+
+	const AThePunchGameState* GameState = World->GetGameState<AThePunchGameState>();
+	UCombatAssetSet* CombatAssets = GameState ? GameState->GetCombatAssets() : NULL;
+	const bool bWasClustered = CombatAssets && CombatAssets->HasAnyInternalFlags(EInternalObjectFlags::ClusterRoot);
+
+	if (bWasClustered && !bClustered)
+	{
+		GUObjectClusters.DissolveCluster(CombatAssets);
+	}
+
+	const FString Name = FString::Printf(TEXT("GC.Fighters%d%s"), Count, bClustered ? TEXT("") : TEXT(".Unclustered"));
+
+	const FCombatBenchmarkResult Result = FCombatBenchmarks::Measure(*Name, Iterations, []()
+	{
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	});
+
+	UE_LOG(LogThePunch, Display, TEXT("GC with %d fighters: %.2f ms, %d objects, %d combat assets %s"),
+		Fighters.Num(), Result.NsPerOp / 1000000.0, GUObjectArray.GetObjectArrayNumMinusAvailable(),
+		CombatAssets ? CombatAssets->GetNumAssets() : 0, CombatAssets && CombatAssets->HasAnyInternalFlags(EInternalObjectFlags::ClusterRoot) ? TEXT("clustered") : TEXT("not clustered"));
+
+	if (bWasClustered && !bClustered)
+	{
+		CombatAssets->CreateCluster();
+	}
+
+	for (AActor* Fighter : Fighters)
+	{
+		Fighter->Destroy();
+	}
+
+	return Result;
+}
+
+static struct FRegisterGarbageCollectionBenchmarks
+{
+	FRegisterGarbageCollectionBenchmarks()
+	{
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkGarbageCollection(World, 100, true); });
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkGarbageCollection(World, 500, true); });
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkGarbageCollection(World, 500, false); });
+	}
+} RegisterGarbageCollectionBenchmarks;
+
+#endif
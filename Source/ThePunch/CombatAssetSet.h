@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "CombatAssetSet.generated.h"
+
+class AThePunchCharacter;
+
+/**
+ * The montages and attack data table of a fighter class, kept resident for a match.
+ * The set is rooted and becomes the root of a GC cluster holding the assets, so a collection
+ * checks the cluster once instead of walking every montage again from each fighter.
+ * Created by AThePunchGameState::BeginPlay from the default pawn class, released in EndPlay.
+ */
+UCLASS()
+class THEPUNCH_API UCombatAssetSet : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	* Gather - collects the assets a fighter uses, including every montage of its data table
+	* @param Fighter usually the class default object of the fighter class
+	*/
+	void Gather(const AThePunchCharacter* Fighter);
+
+	// roots the set and clusters the gathered assets under it; clusters are only built outside the editor and without -NoCombatCluster
+	void MakeResident();
+
+	// unroots the set, the assets are collected with the next GC once nothing else references them
+	void Release();
+
+	/** returns the number of assets held by the set **/
+	int32 GetNumAssets() const { return Assets.Num(); }
+
+	/** returns true while the set is rooted **/
+	bool IsResident() const { return IsRooted(); }
+
+	// UObject interface
+	virtual bool CanBeClusterRoot() const override;
+	// End of UObject interface
+
+private:
+	UPROPERTY()
+	TArray<UObject*> Assets;
+};
@@ -0,0 +1,515 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatBenchmarks.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "AttackStartNotifyState.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+/**
+ * Forwards to the real allocator and counts game thread allocations while a benchmark runs.
+ * Other threads keep allocating through it too, they are just not counted. Once installed,
+ * Inner stays valid for the rest of the process: a thread may still be inside one of these
+ * calls after GMalloc was switched back.
+ */
+class FCombatCountingMalloc : public FMalloc
+{
+public:
+	FCombatCountingMalloc()
+		: Inner(NULL)
+		, NumAllocations(0)
+		, NumBytes(0)
+		, bCounting(false)
+	{
+	}
+
+	virtual void* Malloc(SIZE_T Size, uint32 Alignment) override
+	{
+		CountAllocation(Size);
+		return Inner->Malloc(Size, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Size, uint32 Alignment) override
+	{
+		CountAllocation(Size);
+		return Inner->Realloc(Original, Size, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		Inner->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Size, uint32 Alignment) override
+	{
+		return Inner->QuantizeSize(Size, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return Inner->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return Inner->IsInternallyThreadSafe();
+	}
+
+	virtual void Trim() override
+	{
+		Inner->Trim();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("CombatCountingMalloc");
+	}
+
+	FMalloc* Inner;
+
+	uint64 NumAllocations;
+
+	// requested bytes of the counted allocations, a realloc counts its new size
+	uint64 NumBytes;
+
+	// only read and written on the game thread, like NumAllocations
+	bool bCounting;
+
+private:
+	void CountAllocation(SIZE_T Size)
+	{
+		if (bCounting && IsInGameThread())
+		{
+			++NumAllocations;
+			NumBytes += Size;
+		}
+	}
+};
+
+static FCombatCountingMalloc CombatCountingMalloc;
+
+void FCombatBenchmarks::BeginCountingAllocations()
+{
+	check(IsInGameThread() && !CombatCountingMalloc.bCounting);
+
+	// the allocator below never changes, set it once and never clear it
+	if (CombatCountingMalloc.Inner == NULL)
+	{
+		CombatCountingMalloc.Inner = GMalloc;
+	}
+
+	check(GMalloc == CombatCountingMalloc.Inner);
+
+	CombatCountingMalloc.NumAllocations = 0;
+	CombatCountingMalloc.NumBytes = 0;
+	CombatCountingMalloc.bCounting = true;
+
+	GMalloc = &CombatCountingMalloc;
+}
+
+uint64 FCombatBenchmarks::EndCountingAllocations()
+{
+	check(IsInGameThread());
+
+	GMalloc = CombatCountingMalloc.Inner;
+	CombatCountingMalloc.bCounting = false;
+
+	return CombatCountingMalloc.NumAllocations;
+}
+
+uint64 FCombatBenchmarks::GetCountedBytes()
+{
+	return CombatCountingMalloc.NumBytes;
+}
+
+UClass* FCombatBenchmarks::GetFighterClass(UWorld* World)
+{
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+
+	return GameMode && GameMode->DefaultPawnClass ? *GameMode->DefaultPawnClass : AThePunchCharacter::StaticClass();
+}
+
+TArray<TFunction<FCombatBenchmarkResult(UWorld*)>>& FCombatBenchmarks::GetExtraBenchmarks()
+{
+	static TArray<TFunction<FCombatBenchmarkResult(UWorld*)>> ExtraBenchmarks;
+	return ExtraBenchmarks;
+}
+
+FString FCombatBenchmarks::GetBaselinePath()
+{
+	// a dedicated server strips the cosmetic work, its numbers are kept apart from the client's
+	return FPaths::ProjectConfigDir() / (IsRunningDedicatedServer() ? TEXT("CombatBenchmarkBaseline.Server.json") : TEXT("CombatBenchmarkBaseline.json"));
+}
+
+bool FCombatBenchmarks::HasBaseline()
+{
+	TSharedPtr<FJsonObject> Baseline;
+	FString BaselineText;
+
+	if (!FFileHelper::LoadFileToString(BaselineText, *GetBaselinePath()) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline) || !Baseline.IsValid())
+	{
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject>* BaselineBenchmarks = NULL;
+
+	return Baseline->TryGetObjectField(TEXT("Benchmarks"), BaselineBenchmarks) && (*BaselineBenchmarks)->Values.Num() > 0;
+}
+
+FCombatBenchmarkResult FCombatBenchmarks::MeasureFighterMemory(UWorld* World, int32 Count)
+{
+	UClass* FighterClass = GetFighterClass(World);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// the first fighter loads the meshes, sounds and montages every other one shares
+	AThePunchCharacter* Warmup = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector(0.f, -500.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+
+	TArray<AThePunchCharacter*> Fighters;
+	Fighters.Reserve(Count);
+
+	// the heap bytes the game thread asks for while the fighters are spawned, the rest of the process does not count
+	BeginCountingAllocations();
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		Fighters.Add(World->SpawnActor<AThePunchCharacter>(FighterClass, FVector(200.f * Index, -500.f, 200.f), FRotator::ZeroRotator, SpawnParams));
+	}
+
+	const uint64 NumAllocations = EndCountingAllocations();
+	const uint64 NumBytes = GetCountedBytes();
+
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		if (Fighter)
+		{
+			Fighter->Destroy();
+		}
+	}
+
+	if (Warmup)
+	{
+		Warmup->Destroy();
+	}
+
+	FCombatBenchmarkResult Result;
+	Result.Name = TEXT("Fighter.Memory");
+	Result.NsPerOp = 0.0;
+	Result.AllocsPerOp = double(NumAllocations) / Count;
+	Result.BytesPerOp = double(NumBytes) / Count;
+
+	return Result;
+}
+
+bool FCombatBenchmarks::RunBenchmarks(UWorld* World, TArray<FCombatBenchmarkResult>& OutResults)
+{
+	if (World == NULL)
+	{
+		UE_LOG(LogThePunch, Error, TEXT("ThePunch.Bench needs a world to spawn fighters in"));
+		return false;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// the game's fighter, with the mesh, animation blueprint and montages the attack path uses
+	UClass* FighterClass = GetFighterClass(World);
+
+	AThePunchCharacter* Attacker = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector(0.f, 0.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+	AThePunchCharacter* Victim = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector(100.f, 0.f, 200.f), FRotator(0.f, 180.f, 0.f), SpawnParams);
+
+	if (Attacker == NULL || Victim == NULL)
+	{
+		UE_LOG(LogThePunch, Error, TEXT("ThePunch.Bench could not spawn fighters"));
+		return false;
+	}
+
+	// AttackInput: random section pick and section name
+	OutResults.Add(Measure(TEXT("AttackInput.SectionSelection"), 100000, [Attacker]()
+	{
+		const FPlayerAttackMontage* AttackMontage = Attacker->FindAttackMontage(EAttackType::MELEE_FIST);
+		const int32 SectionCount = AttackMontage ? FMath::Max(AttackMontage->AnimSectionCount, 1) : 3;
+
+		AThePunchCharacter::GetAttackSectionName(rand() % SectionCount + 1);
+	}));
+
+	// attack data table lookup
+	OutResults.Add(Measure(TEXT("AttackData.Lookup"), 100000, [Attacker]()
+	{
+		Attacker->FindAttackMontage(EAttackType::MELEE_FIST);
+		Attacker->FindAttackMontage(EAttackType::MELEE_KICK);
+	}));
+
+	// attack window notify begin and end
+	OutResults.Add(Measure(TEXT("Notify.AttackWindow"), 10000, [Attacker]()
+	{
+		UAttackStartNotifyState* Notify = GetMutableDefault<UAttackStartNotifyState>();
+
+		Notify->NotifyBegin(Attacker->GetMesh(), NULL, 0.2f);
+		Notify->NotifyEnd(Attacker->GetMesh(), NULL);
+	}));
+
+	// FireLineTrace ray generation and query setup, without the trace itself
+	OutResults.Add(Measure(TEXT("FireLineTrace.Prepare"), 100000, [Attacker]()
+	{
+		FVector Start;
+		FVector End;
+		FCollisionQueryParams TraceParams;
+
+		Attacker->PrepareLineTrace(Start, End, TraceParams);
+	}));
+
+	// hit handling on a fighter
+	OutResults.Add(Measure(TEXT("OnAttackHit"), 10000, [Attacker, Victim]()
+	{
+		FHitResult Hit(Victim, Victim->GetCapsuleComponent(), Victim->GetActorLocation(), FVector::ForwardVector);
+
+		Attacker->OnAttackHit(NULL, Victim, Victim->GetCapsuleComponent(), FVector::ZeroVector, Hit);
+	}));
+
+	// Log at each level with the fighter's default outputs
+	const ELogLevel LogLevels[] = { ELogLevel::TRACE, ELogLevel::DEBUG, ELogLevel::INFO, ELogLevel::WARNING, ELogLevel::ERROR };
+	const TCHAR* LogLevelNames[] = { TEXT("Log.Trace"), TEXT("Log.Debug"), TEXT("Log.Info"), TEXT("Log.Warning"), TEXT("Log.Error") };
+
+	for (int32 Index = 0; Index < ARRAY_COUNT(LogLevels); ++Index)
+	{
+		const ELogLevel LogLevel = LogLevels[Index];
+
+		OutResults.Add(Measure(LogLevelNames[Index], 1000, [Attacker, LogLevel]()
+		{
+			if (Attacker->IsLogEnabled(LogLevel))
+			{
+				Attacker->Log(LogLevel, TEXT("ThePunch.Bench"));
+			}
+		}));
+	}
+
+	// full fighter spawn and destroy; compare client and server builds with this one
+	OutResults.Add(Measure(TEXT("Fighter.SpawnDestroy"), 200, [World, FighterClass, &SpawnParams]()
+	{
+		AThePunchCharacter* Fighter = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector(0.f, 500.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+
+		if (Fighter)
+		{
+			Fighter->Destroy();
+		}
+	}));
+
+	// one frame of every tick the fighter has on this target, the actor and its ticking components
+	TArray<UActorComponent*> TickingComponents;
+
+	for (UActorComponent* Component : Attacker->GetComponents())
+	{
+		if (Component && Component->IsComponentTickEnabled())
+		{
+			TickingComponents.Add(Component);
+		}
+	}
+
+	OutResults.Add(Measure(TEXT("Fighter.Tick"), 1000, [Attacker, &TickingComponents]()
+	{
+		const float DeltaSeconds = 1.f / 60.f;
+
+		Attacker->TickActor(DeltaSeconds, LEVELTICK_All, Attacker->PrimaryActorTick);
+
+		for (UActorComponent* Component : TickingComponents)
+		{
+			Component->TickComponent(DeltaSeconds, LEVELTICK_All, &Component->PrimaryComponentTick);
+		}
+	}));
+
+	OutResults.Add(MeasureFighterMemory(World, 100));
+
+	for (const TFunction<FCombatBenchmarkResult(UWorld*)>& Benchmark : GetExtraBenchmarks())
+	{
+		OutResults.Add(Benchmark(World));
+	}
+
+	Attacker->Destroy();
+	Victim->Destroy();
+
+	return true;
+}
+
+bool FCombatBenchmarks::CompareWithBaseline(const TArray<FCombatBenchmarkResult>& Results, bool bUpdateBaseline, TArray<FString>& OutFailures)
+{
+	TSharedPtr<FJsonObject> Baseline;
+	FString BaselineText;
+
+	if (FFileHelper::LoadFileToString(BaselineText, *GetBaselinePath()))
+	{
+		FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline);
+	}
+
+	UE_LOG(LogThePunch, Display, TEXT("Combat benchmarks on a %s, baseline %s"), IsRunningDedicatedServer() ? TEXT("dedicated server") : TEXT("client"), *GetBaselinePath());
+
+	if (!Baseline.IsValid())
+	{
+		Baseline = MakeShareable(new FJsonObject());
+		Baseline->SetNumberField(TEXT("ThresholdPercent"), 20.0);
+	}
+
+	const double ThresholdPercent = Baseline->HasField(TEXT("ThresholdPercent")) ? Baseline->GetNumberField(TEXT("ThresholdPercent")) : 20.0;
+	const TSharedPtr<FJsonObject>* BaselineBenchmarks = NULL;
+	Baseline->TryGetObjectField(TEXT("Benchmarks"), BaselineBenchmarks);
+
+	// the server target exists to strip cosmetic work, put its numbers next to the client's recorded ones
+	TSharedPtr<FJsonObject> ClientBaseline;
+	const TSharedPtr<FJsonObject>* ClientBenchmarks = NULL;
+
+	if (IsRunningDedicatedServer() && FFileHelper::LoadFileToString(BaselineText, *(FPaths::ProjectConfigDir() / TEXT("CombatBenchmarkBaseline.json")))
+		&& FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), ClientBaseline) && ClientBaseline.IsValid())
+	{
+		ClientBaseline->TryGetObjectField(TEXT("Benchmarks"), ClientBenchmarks);
+	}
+
+	TSharedPtr<FJsonObject> NewBenchmarks = MakeShareable(new FJsonObject());
+	TSet<FString> Measured;
+
+	for (const FCombatBenchmarkResult& Result : Results)
+	{
+		Measured.Add(Result.Name);
+
+		const TSharedPtr<FJsonObject>* Entry = NULL;
+		const bool bHasBaseline = BaselineBenchmarks && (*BaselineBenchmarks)->TryGetObjectField(Result.Name, Entry);
+
+		FString Verdict = TEXT("baseline updated");
+
+		// a hard limit holds even while the baseline is rewritten
+		if (!Result.Failure.IsEmpty())
+		{
+			OutFailures.Add(FString::Printf(TEXT("%s: %s"), *Result.Name, *Result.Failure));
+		}
+
+		if (!bUpdateBaseline)
+		{
+			if (bHasBaseline)
+			{
+				const double BaselineNs = (*Entry)->GetNumberField(TEXT("NsPerOp"));
+				const double BaselineAllocs = (*Entry)->GetNumberField(TEXT("AllocsPerOp"));
+				const double BaselineBytes = (*Entry)->HasField(TEXT("BytesPerOp")) ? (*Entry)->GetNumberField(TEXT("BytesPerOp")) : 0.0;
+
+				// time and memory may drift by the threshold, allocations may not grow at all
+				const bool bSlower = Result.NsPerOp > BaselineNs * (1.0 + ThresholdPercent / 100.0);
+				const bool bMoreAllocations = Result.AllocsPerOp > BaselineAllocs + 0.01;
+				const bool bLarger = Result.BytesPerOp > BaselineBytes * (1.0 + ThresholdPercent / 100.0);
+
+				Verdict = FString::Printf(TEXT("baseline %.1f ns/op %.2f allocs/op %.0f bytes/op%s%s%s"), BaselineNs, BaselineAllocs, BaselineBytes,
+					bSlower ? TEXT(" SLOWER") : TEXT(""), bMoreAllocations ? TEXT(" MORE ALLOCATIONS") : TEXT(""), bLarger ? TEXT(" LARGER") : TEXT(""));
+
+				if (bSlower || bMoreAllocations || bLarger)
+				{
+					OutFailures.Add(FString::Printf(TEXT("%s: %.1f ns/op %.2f allocs/op %.0f bytes/op, %s"), *Result.Name, Result.NsPerOp, Result.AllocsPerOp, Result.BytesPerOp, *Verdict));
+				}
+			}
+			else
+			{
+				// a benchmark without a baseline would never be gated
+				Verdict = TEXT("NO BASELINE");
+				OutFailures.Add(FString::Printf(TEXT("%s has no baseline entry, record one with ThePunch.Bench update"), *Result.Name));
+			}
+		}
+
+		const TSharedPtr<FJsonObject>* ClientEntry = NULL;
+
+		if (ClientBenchmarks && (*ClientBenchmarks)->TryGetObjectField(Result.Name, ClientEntry))
+		{
+			const double ClientNs = (*ClientEntry)->GetNumberField(TEXT("NsPerOp"));
+
+			Verdict += FString::Printf(TEXT(", client %.1f ns/op %.2f allocs/op, server at %.0f%% of the client's time"), ClientNs, (*ClientEntry)->GetNumberField(TEXT("AllocsPerOp")),
+				ClientNs > 0.0 ? 100.0 * Result.NsPerOp / ClientNs : 0.0);
+		}
+
+		UE_LOG(LogThePunch, Display, TEXT("%-32s %10.1f ns/op %8.2f allocs/op %10.0f bytes/op  (%s)"), *Result.Name, Result.NsPerOp, Result.AllocsPerOp, Result.BytesPerOp, *Verdict);
+
+		TSharedPtr<FJsonObject> NewEntry = MakeShareable(new FJsonObject());
+		NewEntry->SetNumberField(TEXT("NsPerOp"), Result.NsPerOp);
+		NewEntry->SetNumberField(TEXT("AllocsPerOp"), Result.AllocsPerOp);
+
+		if (Result.BytesPerOp > 0.0)
+		{
+			NewEntry->SetNumberField(TEXT("BytesPerOp"), Result.BytesPerOp);
+		}
+		NewBenchmarks->SetObjectField(Result.Name, NewEntry);
+	}
+
+	// a baseline entry nothing measured is a benchmark that was dropped or renamed
+	if (BaselineBenchmarks && !bUpdateBaseline)
+	{
+		for (const TPair<FString, TSharedPtr<FJsonValue>>& Entry : (*BaselineBenchmarks)->Values)
+		{
+			if (!Measured.Contains(Entry.Key))
+			{
+				OutFailures.Add(FString::Printf(TEXT("%s is in the baseline but was not measured"), *Entry.Key));
+			}
+		}
+	}
+
+	if (Results.Num() == 0)
+	{
+		OutFailures.Add(TEXT("No benchmark ran"));
+	}
+
+	if (bUpdateBaseline)
+	{
+		Baseline->SetObjectField(TEXT("Benchmarks"), NewBenchmarks);
+
+		FString OutputText;
+		FJsonSerializer::Serialize(Baseline.ToSharedRef(), TJsonWriterFactory<>::Create(&OutputText));
+		FFileHelper::SaveStringToFile(OutputText, *GetBaselinePath());
+
+		UE_LOG(LogThePunch, Display, TEXT("Combat benchmark baseline written to %s"), *GetBaselinePath());
+	}
+
+	for (const FString& Failure : OutFailures)
+	{
+		UE_LOG(LogThePunch, Error, TEXT("%s"), *Failure);
+	}
+
+	return OutFailures.Num() == 0;
+}
+
+bool FCombatBenchmarks::Run(UWorld* World, bool bUpdateBaseline)
+{
+	TArray<FCombatBenchmarkResult> Results;
+	TArray<FString> Failures;
+
+	if (!RunBenchmarks(World, Results))
+	{
+		return false;
+	}
+
+	return CompareWithBaseline(Results, bUpdateBaseline, Failures);
+}
+
+static void RunCombatBenchmarksCommand(const TArray<FString>& Args, UWorld* World)
+{
+	const bool bUpdateBaseline = Args.Contains(TEXT("update"));
+	const bool bPassed = FCombatBenchmarks::Run(World, bUpdateBaseline);
+
+	if (Args.Contains(TEXT("exit")))
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CombatBenchmarksCommand(
+	TEXT("ThePunch.Bench"),
+	TEXT("Runs the combat microbenchmarks against Config/CombatBenchmarkBaseline.json, .Server.json on a dedicated server. Args: update (rewrite the baseline), exit (quit, non zero status on regression)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunCombatBenchmarksCommand));
+
+#endif
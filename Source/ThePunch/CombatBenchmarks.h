@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatFrameArena.h"
+
+class UClass;
+class UWorld;
+
+#if !UE_BUILD_SHIPPING
+
+/** result of a single microbenchmark */
+struct FCombatBenchmarkResult
+{
+	FString Name;
+
+	double NsPerOp;
+
+	// game thread heap allocations per operation
+	double AllocsPerOp;
+
+	// heap bytes requested per operation, only set by the memory benchmarks
+	double BytesPerOp;
+
+	// set by a benchmark that checks a hard limit, fails the run whatever the baseline says
+	FString Failure;
+};
+
+/**
+ * Microbenchmarks for the combat hot paths, compared against Config/CombatBenchmarkBaseline.json.
+ * A dedicated server compares against Config/CombatBenchmarkBaseline.Server.json instead, so the
+ * Fighter.Tick and Fighter.Memory entries of the two files are the client and server figures.
+ * Run headless with:
+ *   ThePunch -game -nullrhi -ExecCmds="ThePunch.Bench exit"
+ *   ThePunchServer -log -ExecCmds="ThePunch.Bench exit"
+ * "update" rewrites the baseline with the numbers of this run, "exit" quits with a non zero
+ * status when a benchmark regressed past the baseline threshold.
+ */
+class THEPUNCH_API FCombatBenchmarks
+{
+public:
+	/**
+	* Run - spawns two fighters in World, runs every benchmark and compares with the baseline
+	* @param World world the fighters are spawned in
+	* @param bUpdateBaseline writes the results as the new baseline instead of comparing
+	* @return false when a benchmark regressed
+	*/
+	static bool Run(UWorld* World, bool bUpdateBaseline);
+
+	// spawns two fighters in World and measures every benchmark, the extra ones included
+	static bool RunBenchmarks(UWorld* World, TArray<FCombatBenchmarkResult>& OutResults);
+
+	/**
+	* CompareWithBaseline - checks results against the baseline, or writes them as the new baseline
+	* @param Results the measured benchmarks
+	* @param bUpdateBaseline writes the results instead of comparing
+	* @param OutFailures regressions, failed limits, benchmarks without a baseline entry and baseline entries nothing measured
+	* @return true when there is no failure
+	*/
+	static bool CompareWithBaseline(const TArray<FCombatBenchmarkResult>& Results, bool bUpdateBaseline, TArray<FString>& OutFailures);
+
+	// runs Func Iterations times and measures time and heap allocations per call
+	template<typename FuncType>
+	static FCombatBenchmarkResult Measure(const TCHAR* Name, int32 Iterations, FuncType&& Func);
+
+	// benchmarks registered by other systems, run after the built-in ones
+	static TArray<TFunction<FCombatBenchmarkResult(UWorld*)>>& GetExtraBenchmarks();
+
+	// the game mode's default pawn, the fighter players get, or the native class without a game mode
+	static UClass* GetFighterClass(UWorld* World);
+
+	/** true when the baseline file of this target has recorded entries **/
+	static bool HasBaseline();
+
+private:
+	static void BeginCountingAllocations();
+
+	static uint64 EndCountingAllocations();
+
+	// requested bytes of the allocations counted by the last run
+	static uint64 GetCountedBytes();
+
+	static FString GetBaselinePath();
+
+	// heap bytes and allocations per fighter, counted on the game thread while Count of them are spawned
+	static FCombatBenchmarkResult MeasureFighterMemory(UWorld* World, int32 Count);
+};
+
+template<typename FuncType>
+FCombatBenchmarkResult FCombatBenchmarks::Measure(const TCHAR* Name, int32 Iterations, FuncType&& Func)
+{
+	// warm up name tables, caches and the frame arena so only the steady state is measured
+	for (int32 Index = 0; Index < FMath::Min(Iterations, 100); ++Index)
+	{
+		Func();
+		FCombatFrameArena::Get().Reset();
+	}
+
+	BeginCountingAllocations();
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// every call is treated as its own frame, otherwise the arena would grow for the whole run
+	for (int32 Index = 0; Index < Iterations; ++Index)
+	{
+		Func();
+		FCombatFrameArena::Get().Reset();
+	}
+
+	const uint64 EndCycles = FPlatformTime::Cycles64();
+	const uint64 NumAllocations = EndCountingAllocations();
+
+	FCombatBenchmarkResult Result;
+	Result.Name = Name;
+	Result.NsPerOp = FPlatformTime::GetSecondsPerCycle64() * double(EndCycles - StartCycles) * 1e9 / Iterations;
+	Result.AllocsPerOp = double(NumAllocations) / Iterations;
+	Result.BytesPerOp = 0.0;
+
+	return Result;
+}
+
+#endif
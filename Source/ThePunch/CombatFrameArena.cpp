@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatFrameArena.h"
+#include "ThePunch.h"
+#include "Misc/CoreDelegates.h"
+
+DECLARE_MEMORY_STAT(TEXT("Combat Frame Arena Used"), STAT_CombatFrameArenaUsed, STATGROUP_ThePunch);
+DECLARE_MEMORY_STAT(TEXT("Combat Frame Arena Reserved"), STAT_CombatFrameArenaReserved, STATGROUP_ThePunch);
+
+// size of a regular arena block; bigger requests get a block of their own size
+static const SIZE_T CombatFrameArenaBlockSize = 64 * 1024;
+
+FCombatFrameArena& FCombatFrameArena::Get()
+{
+	static FCombatFrameArena* Arena = NULL;
+
+	if (Arena == NULL)
+	{
+		Arena = new FCombatFrameArena();
+
+		// everything allocated this frame is released once the frame is done
+		FCoreDelegates::OnEndFrame.AddRaw(Arena, &FCombatFrameArena::Reset);
+	}
+
+	return *Arena;
+}
+
+FCombatFrameArena::FCombatFrameArena()
+	: CurrentBlock(0)
+	, Offset(0)
+	, BytesUsed(0)
+	, HighWaterMark(0)
+{
+}
+
+FCombatFrameArena::~FCombatFrameArena()
+{
+	for (const FBlock& Block : Blocks)
+	{
+		FMemory::Free(Block.Data);
+	}
+}
+
+void* FCombatFrameArena::Alloc(SIZE_T Size, uint32 Alignment)
+{
+	check(IsInGameThread());
+
+	while (CurrentBlock < Blocks.Num())
+	{
+		const FBlock& Block = Blocks[CurrentBlock];
+		const SIZE_T AlignedOffset = Align(Offset, Alignment);
+
+		if (AlignedOffset + Size <= Block.Size)
+		{
+			Offset = AlignedOffset + Size;
+			BytesUsed += Size;
+
+			return Block.Data + AlignedOffset;
+		}
+
+		// does not fit, move on to the next block kept from an earlier frame
+		++CurrentBlock;
+		Offset = 0;
+	}
+
+	// only reached while the arena is still growing to its working size
+	const SIZE_T BlockSize = FMath::Max(CombatFrameArenaBlockSize, Align(Size, Alignment));
+	Blocks.Add(FBlock{ (uint8*)FMemory::Malloc(BlockSize, FMath::Max(Alignment, 16u)), BlockSize });
+
+	INC_MEMORY_STAT_BY(STAT_CombatFrameArenaReserved, BlockSize);
+
+	Offset = Size;
+	BytesUsed += Size;
+
+	return Blocks[CurrentBlock].Data;
+}
+
+void FCombatFrameArena::Reset()
+{
+	HighWaterMark = FMath::Max(HighWaterMark, BytesUsed);
+
+	SET_MEMORY_STAT(STAT_CombatFrameArenaUsed, BytesUsed);
+
+	CurrentBlock = 0;
+	Offset = 0;
+	BytesUsed = 0;
+}
+
+SIZE_T FCombatFrameArena::GetBytesReserved() const
+{
+	SIZE_T Reserved = 0;
+
+	for (const FBlock& Block : Blocks)
+	{
+		Reserved += Block.Size;
+	}
+
+	return Reserved;
+}
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Linear allocator for transient combat data on the game thread.
+ * Allocations bump a pointer inside blocks that are kept for the whole session;
+ * everything is released at once at the end of the frame. Nothing allocated from
+ * the arena may be kept past the frame it was allocated in.
+ */
+class THEPUNCH_API FCombatFrameArena
+{
+public:
+	// game thread arena, reset at the end of every frame
+	static FCombatFrameArena& Get();
+
+	~FCombatFrameArena();
+
+	// returns Size bytes aligned to Alignment, valid until the end of the frame
+	void* Alloc(SIZE_T Size, uint32 Alignment);
+
+	// releases every allocation made this frame, keeps the blocks
+	void Reset();
+
+	// bytes handed out since the last reset
+	SIZE_T GetBytesUsed() const { return BytesUsed; }
+
+	// largest amount of bytes used in a single frame
+	SIZE_T GetHighWaterMark() const { return HighWaterMark; }
+
+	// bytes held by the arena blocks
+	SIZE_T GetBytesReserved() const;
+
+private:
+	FCombatFrameArena();
+
+	struct FBlock
+	{
+		uint8* Data;
+		SIZE_T Size;
+	};
+
+	TArray<FBlock> Blocks;
+
+	int32 CurrentBlock;
+
+	SIZE_T Offset;
+
+	SIZE_T BytesUsed;
+
+	SIZE_T HighWaterMark;
+};
+
+/**
+ * Container allocator that takes its memory from the combat frame arena.
+ * Freeing is a no-op, the memory comes back when the arena resets.
+ * e.g. TArray<AThePunchCharacter*, FCombatFrameAllocator> Nearby;
+ */
+class FCombatFrameAllocator
+{
+public:
+	typedef int32 SizeType;
+
+	enum { NeedsElementType = false };
+	enum { RequireRangeCheck = true };
+
+	class ForAnyElementType
+	{
+	public:
+		ForAnyElementType()
+			: Data(nullptr)
+		{
+		}
+
+		FORCEINLINE void MoveToEmpty(ForAnyElementType& Other)
+		{
+			checkSlow(this != &Other);
+
+			Data = Other.Data;
+			Other.Data = nullptr;
+		}
+
+		FORCEINLINE FScriptContainerElement* GetAllocation() const
+		{
+			return Data;
+		}
+
+		void ResizeAllocation(SizeType PreviousNumElements, SizeType NumElements, SIZE_T NumBytesPerElement)
+		{
+			FScriptContainerElement* OldData = Data;
+
+			if (NumElements > 0)
+			{
+				Data = (FScriptContainerElement*)FCombatFrameArena::Get().Alloc(NumElements * NumBytesPerElement, 16);
+
+				// the old allocation stays in the arena until it resets, only copy the live elements
+				if (OldData && PreviousNumElements > 0)
+				{
+					FMemory::Memcpy(Data, OldData, FMath::Min(PreviousNumElements, NumElements) * NumBytesPerElement);
+				}
+			}
+			else
+			{
+				Data = nullptr;
+			}
+		}
+
+		FORCEINLINE SizeType CalculateSlackReserve(SizeType NumElements, SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackReserve(NumElements, NumBytesPerElement, false);
+		}
+
+		FORCEINLINE SizeType CalculateSlackShrink(SizeType NumElements, SizeType NumAllocatedElements, SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackShrink(NumElements, NumAllocatedElements, NumBytesPerElement, false);
+		}
+
+		FORCEINLINE SizeType CalculateSlackGrow(SizeType NumElements, SizeType NumAllocatedElements, SIZE_T NumBytesPerElement) const
+		{
+			return DefaultCalculateSlackGrow(NumElements, NumAllocatedElements, NumBytesPerElement, false);
+		}
+
+		SIZE_T GetAllocatedSize(SizeType NumAllocatedElements, SIZE_T NumBytesPerElement) const
+		{
+			return NumAllocatedElements * NumBytesPerElement;
+		}
+
+		bool HasAllocation()
+		{
+			return !!Data;
+		}
+
+	private:
+		ForAnyElementType(const ForAnyElementType&);
+		ForAnyElementType& operator=(const ForAnyElementType&);
+
+		FScriptContainerElement* Data;
+	};
+
+	template<typename ElementType>
+	class ForElementType : public ForAnyElementType
+	{
+	public:
+		ForElementType()
+		{
+		}
+
+		FORCEINLINE ElementType* GetAllocation() const
+		{
+			return (ElementType*)ForAnyElementType::GetAllocation();
+		}
+	};
+};
+
+template <>
+struct TAllocatorTraits<FCombatFrameAllocator> : TAllocatorTraitsBase<FCombatFrameAllocator>
+{
+	enum { SupportsMove = true };
+};
+
+/**
+ * String builder backed by the combat frame arena, for messages that only live
+ * for the current frame (log lines, debug text).
+ */
+class FCombatFrameString
+{
+public:
+	FCombatFrameString()
+	{
+		Chars.Add(TCHAR(0));
+	}
+
+	FCombatFrameString& Append(const TCHAR* Text)
+	{
+		const int32 Length = FCString::Strlen(Text);
+
+		// overwrite the terminator and add a new one after the text
+		Chars.Pop(false);
+		Chars.Append(Text, Length);
+		Chars.Add(TCHAR(0));
+
+		return *this;
+	}
+
+	FCombatFrameString& Append(const FName& Name)
+	{
+		const FNameEntry* Entry = Name.GetDisplayNameEntry();
+
+		if (Entry->IsWide())
+		{
+			Append(StringCast<TCHAR>(Entry->GetWideName()).Get());
+		}
+		else
+		{
+			Append(StringCast<TCHAR>(Entry->GetAnsiName()).Get());
+		}
+
+		if (Name.GetNumber() != NAME_NO_NUMBER_INTERNAL)
+		{
+			Append(TEXT("_"));
+			Append(NAME_INTERNAL_TO_EXTERNAL(Name.GetNumber()));
+		}
+
+		return *this;
+	}
+
+	FCombatFrameString& Append(int32 Value)
+	{
+		TCHAR Buffer[16];
+		FCString::Sprintf(Buffer, TEXT("%d"), Value);
+
+		return Append(Buffer);
+	}
+
+	FCombatFrameString& Append(float Value)
+	{
+		TCHAR Buffer[32];
+		FCString::Sprintf(Buffer, TEXT("%.2f"), Value);
+
+		return Append(Buffer);
+	}
+
+	// null terminated text, valid until the end of the frame
+	const TCHAR* operator*() const
+	{
+		return Chars.GetData();
+	}
+
+	int32 Len() const
+	{
+		return Chars.Num() - 1;
+	}
+
+private:
+	TArray<TCHAR, FCombatFrameAllocator> Chars;
+};
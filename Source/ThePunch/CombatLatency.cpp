@@ -0,0 +1,342 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatLatency.h"
+#include "ThePunch.h"
+#include "CombatBenchmarks.h"
+#include "ThePunchCharacter.h"
+#include "Engine/World.h"
+#include "Animation/AnimInstance.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Merge Latency Histograms"), STAT_MergeLatencyHistograms, STATGROUP_ThePunch);
+
+static TAutoConsoleVariable<float> CVarMetricsExportInterval(
+	TEXT("ThePunch.Metrics.ExportInterval"),
+	10.f,
+	TEXT("Seconds between writes of Saved/Metrics/ThePunch.prom, 0 disables the export"));
+
+//////////////////////////////////////////////////////////////////////////
+// FCombatLatencyHistogram
+
+FCombatLatencyHistogram::FCombatLatencyHistogram()
+	: SumMicroseconds(0)
+{
+	FMemory::Memzero((void*)Counts, sizeof(Counts));
+}
+
+int32 FCombatLatencyHistogram::GetBucketIndex(uint64 Microseconds)
+{
+	// values below the sub bucket count are exact
+	if (Microseconds < SubBucketCount)
+	{
+		return (int32)Microseconds;
+	}
+
+	const int32 Exponent = FMath::Min((int32)FMath::FloorLog2_64(Microseconds), MaxExponent - 1);
+	const int32 Shift = Exponent - SubBucketBits;
+	const int32 SubBucket = FMath::Min((int32)(Microseconds >> Shift), 2 * SubBucketCount - 1) - SubBucketCount;
+
+	return SubBucketCount + Shift * SubBucketCount + SubBucket;
+}
+
+uint64 FCombatLatencyHistogram::GetBucketUpperBound(int32 BucketIndex)
+{
+	if (BucketIndex < SubBucketCount)
+	{
+		return BucketIndex;
+	}
+
+	const int32 Shift = (BucketIndex - SubBucketCount) / SubBucketCount;
+	const int32 SubBucket = (BucketIndex - SubBucketCount) % SubBucketCount;
+
+	return ((uint64(SubBucketCount + SubBucket + 1)) << Shift) - 1;
+}
+
+void FCombatLatencyHistogram::Record(uint64 Microseconds)
+{
+	FPlatformAtomics::InterlockedIncrement(&Counts[GetBucketIndex(Microseconds)]);
+	FPlatformAtomics::InterlockedAdd(&SumMicroseconds, (int64)Microseconds);
+}
+
+void FCombatLatencyHistogram::MergeInto(FCombatLatencyHistogram& Target)
+{
+	// exchanging with zero keeps values recorded during the merge for the next one
+	for (int32 Index = 0; Index < BucketCount; ++Index)
+	{
+		if (Counts[Index] != 0)
+		{
+			Target.Counts[Index] += FPlatformAtomics::InterlockedExchange(&Counts[Index], 0);
+		}
+	}
+
+	Target.SumMicroseconds += FPlatformAtomics::InterlockedExchange(&SumMicroseconds, 0);
+}
+
+int64 FCombatLatencyHistogram::GetCount() const
+{
+	int64 Count = 0;
+
+	for (int32 Index = 0; Index < BucketCount; ++Index)
+	{
+		Count += Counts[Index];
+	}
+
+	return Count;
+}
+
+uint64 FCombatLatencyHistogram::GetValueAtPercentile(double Percentile) const
+{
+	const int64 Count = GetCount();
+
+	if (Count == 0)
+	{
+		return 0;
+	}
+
+	const int64 Rank = FMath::Max<int64>(1, (int64)FMath::CeilToDouble(Count * FMath::Clamp(Percentile, 0.0, 100.0) / 100.0));
+	int64 Seen = 0;
+
+	for (int32 Index = 0; Index < BucketCount; ++Index)
+	{
+		Seen += Counts[Index];
+
+		if (Seen >= Rank)
+		{
+			return GetBucketUpperBound(Index);
+		}
+	}
+
+	return GetBucketUpperBound(BucketCount - 1);
+}
+
+void FCombatLatencyHistogram::WritePrometheus(FString& Out, const TCHAR* Name, const TCHAR* Help) const
+{
+	Out += FString::Printf(TEXT("# HELP %s %s\n# TYPE %s histogram\n"), Name, Help, Name);
+
+	// one exported bucket per power of two, the sub buckets only sharpen the percentiles
+	int64 Cumulative = 0;
+	int32 Index = 0;
+
+	for (int32 Exponent = 0; Exponent < MaxExponent; ++Exponent)
+	{
+		const uint64 UpperBound = (uint64(1) << Exponent);
+
+		// le is inclusive, a bucket whose upper bound equals it belongs to it
+		while (Index < BucketCount && GetBucketUpperBound(Index) <= UpperBound)
+		{
+			Cumulative += Counts[Index];
+			++Index;
+		}
+
+		// buckets past a minute are empty in practice, keep the series count small
+		if (UpperBound > 60ull * 1000000ull)
+		{
+			break;
+		}
+
+		Out += FString::Printf(TEXT("%s_bucket{le=\"%g\"} %lld\n"), Name, UpperBound / 1000000.0, Cumulative);
+	}
+
+	const int64 Count = GetCount();
+
+	Out += FString::Printf(TEXT("%s_bucket{le=\"+Inf\"} %lld\n"), Name, Count);
+	Out += FString::Printf(TEXT("%s_sum %g\n"), Name, SumMicroseconds / 1000000.0);
+	Out += FString::Printf(TEXT("%s_count %lld\n"), Name, Count);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FCombatLatency
+
+bool FCombatLatency::bEnabled = true;
+
+FCombatLatency& FCombatLatency::Get()
+{
+	// initialized exactly once even when the first Record calls race on several threads
+	static FCombatLatency Latency;
+
+	return Latency;
+}
+
+FCombatLatency::FCombatLatency()
+	: LastExportTime(FPlatformTime::Seconds())
+{
+	FCoreDelegates::OnEndFrame.AddRaw(this, &FCombatLatency::EndFrame);
+}
+
+void FCombatLatency::EndFrame()
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_MergeLatencyHistograms);
+
+		for (int32 Index = 0; Index < (int32)ECombatLatency::COUNT; ++Index)
+		{
+			Frame[Index].MergeInto(Total[Index]);
+		}
+	}
+
+	const float ExportInterval = CVarMetricsExportInterval.GetValueOnGameThread();
+	const double Now = FPlatformTime::Seconds();
+
+	if (ExportInterval > 0.f && Now - LastExportTime >= ExportInterval)
+	{
+		LastExportTime = Now;
+		Export();
+	}
+}
+
+FString FCombatLatency::GetExportPath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Metrics") / TEXT("ThePunch.prom");
+}
+
+void FCombatLatency::Export()
+{
+	FString Text;
+
+	Total[(int32)ECombatLatency::INPUT_TO_MONTAGE].WritePrometheus(Text, TEXT("thepunch_input_to_montage_seconds"), TEXT("Time from attack input until the attack montage plays"));
+	Total[(int32)ECombatLatency::MONTAGE_TO_HIT].WritePrometheus(Text, TEXT("thepunch_montage_to_first_hit_seconds"), TEXT("Time from attack montage start until the first hit of the attack"));
+	Total[(int32)ECombatLatency::LINE_TRACE].WritePrometheus(Text, TEXT("thepunch_line_trace_seconds"), TEXT("FireLineTrace scene query time"));
+	Total[(int32)ECombatLatency::HIT_TO_AUDIO].WritePrometheus(Text, TEXT("thepunch_hit_to_audio_seconds"), TEXT("Time from the hit callback until the punch sound plays"));
+
+	const FString Path = GetExportPath();
+
+	// the scraper may read at any time, write a temporary file and move it over the old one
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Text, Path]()
+	{
+		const FString TempPath = Path + TEXT(".tmp");
+
+		if (FFileHelper::SaveStringToFile(Text, *TempPath))
+		{
+			IFileManager::Get().Move(*Path, *TempPath, true, true);
+		}
+	});
+}
+
+#if !UE_BUILD_SHIPPING
+
+static void DumpCombatLatency()
+{
+	static const TCHAR* IntervalNames[] = { TEXT("Input to montage"), TEXT("Montage to first hit"), TEXT("Line trace"), TEXT("Hit to audio") };
+
+	for (int32 Index = 0; Index < (int32)ECombatLatency::COUNT; ++Index)
+	{
+		const FCombatLatencyHistogram& Histogram = FCombatLatency::Get().GetTotal((ECombatLatency)Index);
+
+		UE_LOG(LogThePunch, Display, TEXT("%-22s count %8lld  p50 %8llu us  p99 %8llu us  p99.9 %8llu us"), IntervalNames[Index],
+			Histogram.GetCount(), Histogram.GetValueAtPercentile(50.0), Histogram.GetValueAtPercentile(99.0), Histogram.GetValueAtPercentile(99.9));
+	}
+
+	FCombatLatency::Get().Export();
+}
+
+static FAutoConsoleCommand DumpCombatLatencyCommand(
+	TEXT("ThePunch.Latency"),
+	TEXT("Prints the combat latency percentiles and writes Saved/Metrics/ThePunch.prom"),
+	FConsoleCommandDelegate::CreateStatic(&DumpCombatLatency));
+
+// the same attack with the histograms switched on and off, the instrumented one must stay within 1%
+static FCombatBenchmarkResult BenchmarkLatencyOverhead(UWorld* World)
+{
+	static const int32 Rounds = 5;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	UClass* FighterClass = FCombatBenchmarks::GetFighterClass(World);
+	AThePunchCharacter* Attacker = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector(0.f, -500.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+	AThePunchCharacter* Victim = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector(100.f, -500.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+
+	const FPlayerAttackMontage* AttackMontage = Attacker ? Attacker->FindAttackMontage(EAttackType::MELEE_FIST) : NULL;
+	USkeletalMeshComponent* Mesh = Attacker ? Attacker->GetMesh() : NULL;
+	UAnimInstance* AnimInstance = Mesh ? Mesh->GetAnimInstance() : NULL;
+
+	FCombatBenchmarkResult Result;
+	Result.Name = TEXT("Latency.InstrumentedAttack");
+
+	if (Victim == NULL || AttackMontage == NULL || AttackMontage->Montage == NULL || AnimInstance == NULL)
+	{
+		Result.Failure = TEXT("Latency instrumentation overhead needs a fighter with a punch montage to attack with");
+	}
+	else
+	{
+		UAnimMontage* Montage = AttackMontage->Montage;
+
+		// input to montage, montage to hit and the trace: every interval an attack records
+		const auto Attack = [Attacker, Victim, AnimInstance, Mesh, Montage]()
+		{
+			Attacker->AttackInput(EAttackType::MELEE_FIST);
+			Attacker->AttackStart();
+
+			FHitResult Hit(Victim, Victim->GetCapsuleComponent(), Victim->GetActorLocation(), FVector::ForwardVector);
+			Attacker->OnAttackHit(NULL, Victim, Victim->GetCapsuleComponent(), FVector::ZeroVector, Hit);
+
+			Attacker->AttackEnd();
+
+			AnimInstance->Montage_Stop(0.f, Montage);
+			Mesh->TickAnimation(1.f / 60.f, false);
+		};
+
+		const bool bWasEnabled = FCombatLatency::IsEnabled();
+		double UninstrumentedNs = 0.0;
+
+		// alternate the two so clock and cache drift hits both alike, keep the fastest round of each
+		for (int32 Round = 0; Round < Rounds; ++Round)
+		{
+			FCombatLatency::SetEnabled(false);
+			const FCombatBenchmarkResult Off = FCombatBenchmarks::Measure(TEXT("Latency.UninstrumentedAttack"), 1000, Attack);
+
+			FCombatLatency::SetEnabled(true);
+			const FCombatBenchmarkResult On = FCombatBenchmarks::Measure(TEXT("Latency.InstrumentedAttack"), 1000, Attack);
+
+			if (Round == 0 || Off.NsPerOp < UninstrumentedNs)
+			{
+				UninstrumentedNs = Off.NsPerOp;
+			}
+
+			if (Round == 0 || On.NsPerOp < Result.NsPerOp)
+			{
+				Result = On;
+			}
+		}
+
+		FCombatLatency::SetEnabled(bWasEnabled);
+
+		const double OverheadPercent = UninstrumentedNs > 0.0 ? 100.0 * (Result.NsPerOp - UninstrumentedNs) / UninstrumentedNs : 0.0;
+
+		UE_LOG(LogThePunch, Display, TEXT("Latency instrumentation adds %.2f%% to an attack (%.0f ns against %.0f ns)"), OverheadPercent, Result.NsPerOp, UninstrumentedNs);
+
+		if (OverheadPercent > 1.0)
+		{
+			Result.Failure = FString::Printf(TEXT("Latency instrumentation adds %.2f%% to an attack, over the 1%% limit"), OverheadPercent);
+		}
+	}
+
+	if (Attacker)
+	{
+		Attacker->Destroy();
+	}
+
+	if (Victim)
+	{
+		Victim->Destroy();
+	}
+
+	return Result;
+}
+
+static struct FRegisterLatencyBenchmark
+{
+	FRegisterLatencyBenchmark()
+	{
+		FCombatBenchmarks::GetExtraBenchmarks().Add(&BenchmarkLatencyOverhead);
+	}
+} RegisterLatencyBenchmark;
+
+#endif
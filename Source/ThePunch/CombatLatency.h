@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// 0 compiles the clock reads and histogram writes of the combat paths out of the game
+#ifndef WITH_COMBAT_LATENCY
+#define WITH_COMBAT_LATENCY 1
+#endif
+
+/** gameplay intervals that are measured in production */
+enum class ECombatLatency : uint8
+{
+	// AttackInput until the attack montage is playing
+	INPUT_TO_MONTAGE,
+	// attack montage start until the first hit of that attack
+	MONTAGE_TO_HIT,
+	// FireLineTrace scene query
+	LINE_TRACE,
+	// OnAttackHit until the punch sound is playing
+	HIT_TO_AUDIO,
+	COUNT
+};
+
+/**
+ * Log-linear (HDR style) histogram of microsecond values: every power of two is split
+ * into 8 linear buckets, so any value is kept within 12.5% from 1 us up to hours.
+ * Record is a pair of atomic adds and can be called from any thread.
+ */
+class THEPUNCH_API FCombatLatencyHistogram
+{
+public:
+	enum { SubBucketBits = 3 };
+	enum { SubBucketCount = 1 << SubBucketBits };
+	enum { MaxExponent = 36 };
+	enum { BucketCount = SubBucketCount + (MaxExponent - SubBucketBits) * SubBucketCount };
+
+	FCombatLatencyHistogram();
+
+	void Record(uint64 Microseconds);
+
+	// moves every recorded value into Total and leaves this histogram empty
+	void MergeInto(FCombatLatencyHistogram& Total);
+
+	// smallest value that Percentile (0-100) of the recorded values are below or equal to
+	uint64 GetValueAtPercentile(double Percentile) const;
+
+	int64 GetCount() const;
+
+	/**
+	* WritePrometheus - appends the histogram in Prometheus text exposition format,
+	* with cumulative buckets at every power of two microseconds, in seconds
+	* @param Out text to append to
+	* @param Name metric name without suffix
+	* @param Help description of the metric
+	*/
+	void WritePrometheus(FString& Out, const TCHAR* Name, const TCHAR* Help) const;
+
+	static int32 GetBucketIndex(uint64 Microseconds);
+
+	// largest value that falls into the bucket
+	static uint64 GetBucketUpperBound(int32 BucketIndex);
+
+private:
+	volatile int64 Counts[BucketCount];
+
+	volatile int64 SumMicroseconds;
+};
+
+/**
+ * Latency histograms of the combat paths. Values are recorded into a frame histogram
+ * from anywhere and merged into the process totals at the end of every frame; the totals
+ * are written to Saved/Metrics/ThePunch.prom every ThePunch.Metrics.ExportInterval seconds.
+ */
+class THEPUNCH_API FCombatLatency
+{
+public:
+	/** returns the cycles an interval starts from, 0 while recording is off **/
+	static uint64 Now()
+	{
+		return IsEnabled() ? FPlatformTime::Cycles64() : 0;
+	}
+
+	/** records the time since StartCycles (FCombatLatency::Now) for Interval, nothing for an interval that never started **/
+	static void Record(ECombatLatency Interval, uint64 StartCycles)
+	{
+		if (StartCycles != 0)
+		{
+			Get().Frame[(int32)Interval].Record(CyclesToMicroseconds(FPlatformTime::Cycles64() - StartCycles));
+		}
+	}
+
+	/** false when compiled out or switched off with SetEnabled **/
+	static bool IsEnabled()
+	{
+#if WITH_COMBAT_LATENCY
+		return bEnabled;
+#else
+		return false;
+#endif
+	}
+
+	// turns recording off at runtime, the combat paths then skip every clock read
+	static void SetEnabled(bool bInEnabled) { bEnabled = bInEnabled; }
+
+	// created on first use; the module creates it at startup so the end of frame delegate is bound on the game thread
+	static FCombatLatency& Get();
+
+	// merges the frame histograms, exports when the interval elapsed; bound to the end of frame
+	void EndFrame();
+
+	// writes the totals now
+	void Export();
+
+	const FCombatLatencyHistogram& GetTotal(ECombatLatency Interval) const { return Total[(int32)Interval]; }
+
+	static FString GetExportPath();
+
+private:
+	FCombatLatency();
+
+	static uint64 CyclesToMicroseconds(uint64 Cycles)
+	{
+		return uint64(Cycles * FPlatformTime::GetSecondsPerCycle64() * 1000000.0);
+	}
+
+	FCombatLatencyHistogram Frame[(int32)ECombatLatency::COUNT];
+
+	FCombatLatencyHistogram Total[(int32)ECombatLatency::COUNT];
+
+	double LastExportTime;
+
+	static bool bEnabled;
+};
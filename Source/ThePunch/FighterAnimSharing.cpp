@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FighterAnimSharing.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "CombatBenchmarks.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PawnMovementComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Anim Sharing"), STAT_UpdateAnimSharing, STATGROUP_ThePunch);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Sharing Leaders"), STAT_AnimSharingLeaders, STATGROUP_ThePunch);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Anim Sharing Followers"), STAT_AnimSharingFollowers, STATGROUP_ThePunch);
+
+// width of the speed bands idle, walk and run poses are shared in
+static const float LocomotionSpeedStep = 75.f;
+
+FFighterAnimSharing::FFighterAnimSharing()
+{
+	UniqueEvaluationDistance = 1500.f;
+	TimeStep = 1.f / 15.f;
+	HitReactionTime = 0.5f;
+}
+
+void FFighterAnimSharing::Update(const TArray<AThePunchCharacter*>& Fighters, const FVector& ViewLocation, bool bHasViewer)
+{
+	SCOPE_CYCLE_COUNTER(STAT_UpdateAnimSharing);
+
+	Leaders.Reset();
+
+	uint32 NumLeaders = 0;
+	uint32 NumFollowers = 0;
+
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		USkeletalMeshComponent* Mesh = Fighter ? Fighter->GetMesh() : NULL;
+
+		if (Mesh == NULL || Fighter->IsPendingKill())
+		{
+			continue;
+		}
+
+		USkeletalMeshComponent* Leader = NULL;
+
+		if (CanShare(Fighter, ViewLocation, bHasViewer))
+		{
+			const FBucketKey Key = MakeKey(Fighter);
+			USkeletalMeshComponent** Existing = Leaders.Find(Key);
+
+			if (Existing)
+			{
+				Leader = *Existing;
+			}
+			else
+			{
+				// first fighter in the bucket evaluates the pose for everyone else
+				Leaders.Add(Key, Mesh);
+			}
+		}
+
+		if (Mesh->MasterPoseComponent.Get() != Leader)
+		{
+			Mesh->SetMasterPoseComponent(Leader);
+		}
+
+		if (Leader)
+		{
+			++NumFollowers;
+		}
+		else
+		{
+			++NumLeaders;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_AnimSharingLeaders, NumLeaders);
+	SET_DWORD_STAT(STAT_AnimSharingFollowers, NumFollowers);
+}
+
+void FFighterAnimSharing::Reset(const TArray<AThePunchCharacter*>& Fighters)
+{
+	Leaders.Reset();
+
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		if (Fighter && Fighter->GetMesh() && Fighter->GetMesh()->MasterPoseComponent.IsValid())
+		{
+			Fighter->GetMesh()->SetMasterPoseComponent(NULL);
+		}
+	}
+}
+
+bool FFighterAnimSharing::CanShare(const AThePunchCharacter* Fighter, const FVector& ViewLocation, bool bHasViewer) const
+{
+	// hit detection needs the fighter's own bones while its hitboxes are live
+	if (Fighter->GetIsAttackWindowOpen())
+	{
+		return false;
+	}
+
+	// physics hit reactions drive the fighter's own bodies
+	if (Fighter->IsSimulatingHitReaction() || Fighter->GetWorld()->GetTimeSeconds() - Fighter->GetLastHitReceivedTime() < HitReactionTime)
+	{
+		return false;
+	}
+
+	if (bHasViewer && FVector::DistSquared(Fighter->GetActorLocation(), ViewLocation) < FMath::Square(UniqueEvaluationDistance))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+FFighterAnimSharing::FBucketKey FFighterAnimSharing::MakeKey(const AThePunchCharacter* Fighter) const
+{
+	FBucketKey Key;
+	Key.Mesh = Fighter->GetMesh()->SkeletalMesh;
+	Key.Montage = NULL;
+	Key.Section = NAME_None;
+	Key.Step = 0;
+
+	UAnimInstance* AnimInstance = Fighter->GetMesh()->GetAnimInstance();
+	UAnimMontage* Montage = AnimInstance ? AnimInstance->GetCurrentActiveMontage() : NULL;
+
+	if (Montage)
+	{
+		Key.Montage = Montage;
+		Key.Section = AnimInstance->Montage_GetCurrentSection(Montage);
+		Key.Step = FMath::FloorToInt(AnimInstance->Montage_GetPosition(Montage) / TimeStep);
+	}
+	else
+	{
+		// idle, walk and run share by speed band; falling fighters get their own band.
+		// locomotion uses negative steps so it never collides with montage time steps
+		const bool bIsInAir = Fighter->GetMovementComponent() && Fighter->GetMovementComponent()->IsFalling();
+		const int32 SpeedBand = FMath::FloorToInt(Fighter->GetVelocity().Size() / LocomotionSpeedStep);
+
+		Key.Step = bIsInAir ? -1 : -2 - SpeedBand;
+	}
+
+	return Key;
+}
+
+#if !UE_BUILD_SHIPPING
+
+// a background crowd seen from a client camera, every fighter evaluating its own pose or sharing; the game
+// state only shares with a local viewer, so the pass is driven here as if one looked on, even on a headless run
+static FCombatBenchmarkResult BenchmarkCrowdPoses(UWorld* World, bool bShare)
+{
+	static const int32 Count = 100;
+	static const float Spacing = 200.f;
+	static const float CrowdY = 30000.f;
+
+	UClass* FighterClass = FCombatBenchmarks::GetFighterClass(World);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TArray<AThePunchCharacter*> Crowd;
+	Crowd.Reserve(Count);
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		AThePunchCharacter* Fighter = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector((Index % 10) * Spacing, CrowdY + (Index / 10) * Spacing, 200.f), FRotator::ZeroRotator, SpawnParams);
+
+		if (Fighter == NULL)
+		{
+			continue;
+		}
+
+		// nothing is rendered without a viewport, evaluate as a fighter on screen would
+		Fighter->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones;
+
+		// half the crowd attacks, the rest idles
+		if (Index % 2)
+		{
+			Fighter->AttackInput(EAttackType::MELEE_FIST);
+		}
+
+		Crowd.Add(Fighter);
+	}
+
+	// the camera stands behind the crowd, beyond the distance that keeps poses unique
+	FFighterAnimSharing AnimSharing;
+	const FVector ViewLocation(0.f, CrowdY - 3000.f, 200.f);
+
+	const FCombatBenchmarkResult Result = FCombatBenchmarks::Measure(bShare ? TEXT("AnimSharing.Crowd100Shared") : TEXT("AnimSharing.Crowd100Unique"), 100,
+		[&AnimSharing, &Crowd, &ViewLocation, bShare]()
+	{
+		if (bShare)
+		{
+			AnimSharing.Update(Crowd, ViewLocation, true);
+		}
+
+		for (AThePunchCharacter* Fighter : Crowd)
+		{
+			Fighter->GetMesh()->TickComponent(1.f / 60.f, LEVELTICK_All, NULL);
+		}
+	});
+
+	AnimSharing.Reset(Crowd);
+
+	for (AThePunchCharacter* Fighter : Crowd)
+	{
+		Fighter->Destroy();
+	}
+
+	return Result;
+}
+
+static struct FRegisterCrowdPoseBenchmarks
+{
+	FRegisterCrowdPoseBenchmarks()
+	{
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkCrowdPoses(World, false); });
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkCrowdPoses(World, true); });
+	}
+} RegisterCrowdPoseBenchmarks;
+
+#endif
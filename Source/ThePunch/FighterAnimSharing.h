@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AThePunchCharacter;
+class UAnimMontage;
+class USkeletalMesh;
+class USkeletalMeshComponent;
+
+/**
+ * Shares one evaluated pose between background fighters that are doing the same thing.
+ * Fighters are bucketed by (montage, section, quantized montage time) or by locomotion
+ * state when no montage plays. The first fighter of a bucket evaluates its pose and the
+ * others follow it through the master pose component, so they keep updating their own
+ * montage and notifies but skip pose evaluation.
+ */
+class THEPUNCH_API FFighterAnimSharing
+{
+public:
+	FFighterAnimSharing();
+
+	/**
+	* Update - picks a leader per bucket and points every follower at it
+	* @param Fighters every fighter in the match
+	* @param ViewLocation location of the local camera
+	* @param bHasViewer false without a local viewer, then distance is ignored
+	*/
+	void Update(const TArray<AThePunchCharacter*>& Fighters, const FVector& ViewLocation, bool bHasViewer);
+
+	// puts every fighter back on its own pose evaluation
+	void Reset(const TArray<AThePunchCharacter*>& Fighters);
+
+	// fighters closer than this to the camera always evaluate their own pose
+	float UniqueEvaluationDistance;
+
+	// montage time step in seconds; fighters within the same step share a pose
+	float TimeStep;
+
+	// fighters hit less than this many seconds ago keep their own pose
+	float HitReactionTime;
+
+private:
+	struct FBucketKey
+	{
+		const USkeletalMesh* Mesh;
+		const UAnimMontage* Montage;
+		FName Section;
+		int32 Step;
+
+		bool operator==(const FBucketKey& Other) const
+		{
+			return Mesh == Other.Mesh && Montage == Other.Montage && Section == Other.Section && Step == Other.Step;
+		}
+
+		friend uint32 GetTypeHash(const FBucketKey& Key)
+		{
+			uint32 Hash = HashCombine(PointerHash(Key.Mesh), PointerHash(Key.Montage));
+			Hash = HashCombine(Hash, GetTypeHash(Key.Section));
+			return HashCombine(Hash, GetTypeHash(Key.Step));
+		}
+	};
+
+	// false when the fighter has to keep its own pose
+	bool CanShare(const AThePunchCharacter* Fighter, const FVector& ViewLocation, bool bHasViewer) const;
+
+	FBucketKey MakeKey(const AThePunchCharacter* Fighter) const;
+
+	// leader mesh of every bucket seen this frame
+	TMap<FBucketKey, USkeletalMeshComponent*> Leaders;
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FighterNetInterest.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchArena.h"
+#include "FighterSpatialGrid.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Update Net Interest"), STAT_UpdateNetInterest, STATGROUP_ThePunch);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Interest Pairs"), STAT_NetInterestPairs, STATGROUP_ThePunch);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dormant Fighters"), STAT_DormantFighters, STATGROUP_ThePunch);
+
+FFighterNetInterest::FFighterNetInterest()
+	: InterestRadius(5000.f)
+	, UpdateFrame(0)
+{
+}
+
+void FFighterNetInterest::Update(UWorld* World, const TArray<AThePunchCharacter*>& Fighters, const FFighterSpatialGrid& MatchGrid)
+{
+	SCOPE_CYCLE_COUNTER(STAT_UpdateNetInterest);
+
+	++UpdateFrame;
+
+	int32 NumPairs = 0;
+
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		const AActor* ViewTarget = PlayerController ? PlayerController->GetViewTarget() : NULL;
+
+		if (ViewTarget == NULL)
+		{
+			continue;
+		}
+
+		// fighters of other arenas are never relevant
+		const AThePunchCharacter* ViewFighter = Cast<AThePunchCharacter>(ViewTarget);
+		const FFighterSpatialGrid& Grid = ViewFighter && ViewFighter->GetArena() ? ViewFighter->GetArena()->GetFighterGrid() : MatchGrid;
+
+		// lists are kept between frames so their memory is reused
+		FViewerInterest& Interest = Viewers.FindOrAdd(ViewTarget);
+		Interest.Fighters.Reset();
+		Interest.UpdateFrame = UpdateFrame;
+
+		QueryResults.Reset();
+		Grid.QueryRadius(ViewTarget->GetActorLocation(), InterestRadius, QueryResults);
+
+		for (const AThePunchCharacter* Fighter : QueryResults)
+		{
+			Interest.Fighters.Add(Fighter);
+		}
+
+		NumPairs += Interest.Fighters.Num();
+	}
+
+	for (auto It = Viewers.CreateIterator(); It; ++It)
+	{
+		if (It.Value().UpdateFrame != UpdateFrame)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	int32 NumDormant = 0;
+
+	for (const AThePunchCharacter* Fighter : Fighters)
+	{
+		NumDormant += Fighter->NetDormancy == DORM_DormantAll ? 1 : 0;
+	}
+
+	SET_DWORD_STAT(STAT_NetInterestPairs, NumPairs);
+	SET_DWORD_STAT(STAT_DormantFighters, NumDormant);
+}
+
+bool FFighterNetInterest::FindRelevance(const AActor* ViewTarget, const AThePunchCharacter* Fighter, bool& bOutRelevant) const
+{
+	const FViewerInterest* Interest = Viewers.Find(ViewTarget);
+
+	if (Interest == NULL)
+	{
+		return false;
+	}
+
+	bOutRelevant = Interest->Fighters.Contains(Fighter);
+
+	return true;
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class AThePunchCharacter;
+class FFighterSpatialGrid;
+class UWorld;
+
+/**
+ * Server side replication interest. Once per frame every connection's view target queries
+ * the fighter grid around itself, so relevancy costs grow with the number of fighters near
+ * each viewer instead of fighters times connections. AThePunchCharacter::IsNetRelevantFor
+ * answers from these lists. Viewers that are not fighters of an arena, like spectators, use
+ * the grid of the whole match.
+ * Update rates are not per connection: the engine sends an actor at its one NetUpdateFrequency
+ * to every connection it is relevant to, see AThePunchCharacter::UpdateNetInterest.
+ */
+class THEPUNCH_API FFighterNetInterest
+{
+public:
+	FFighterNetInterest();
+
+	/**
+	* Update - rebuilds the interest list of every player's view target
+	* @param World world whose player controllers are the viewers
+	* @param Fighters every fighter in the match, only used for stats
+	* @param MatchGrid grid of the match, viewers inside an arena use the arena grid
+	*/
+	void Update(UWorld* World, const TArray<AThePunchCharacter*>& Fighters, const FFighterSpatialGrid& MatchGrid);
+
+	/**
+	* FindRelevance - looks Fighter up in the interest list of ViewTarget
+	* @param bOutRelevant set when the viewer has a list
+	* @return false when the viewer has no list yet, the engine rules apply then
+	*/
+	bool FindRelevance(const AActor* ViewTarget, const AThePunchCharacter* Fighter, bool& bOutRelevant) const;
+
+	// 2D distance around a viewer in which fighters are relevant
+	float InterestRadius;
+
+private:
+	struct FViewerInterest
+	{
+		// a set, relevancy asks once per fighter and connection
+		TSet<const AThePunchCharacter*> Fighters;
+
+		// frame of the last update, lists of viewers that went away are dropped
+		uint32 UpdateFrame;
+	};
+
+	TMap<const AActor*, FViewerInterest> Viewers;
+
+	// grid query results, reused by every viewer
+	TArray<AThePunchCharacter*> QueryResults;
+
+	uint32 UpdateFrame;
+};
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FighterSpatialGrid.h"
+#include "ThePunchCharacter.h"
+
+FFighterSpatialGrid::FFighterSpatialGrid(float InCellSize)
+	: CellSize(FMath::Max(InCellSize, 1.f))
+{
+}
+
+FIntPoint FFighterSpatialGrid::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+uint64 FFighterSpatialGrid::MakeCellKey(const FIntPoint& Cell)
+{
+	return (uint64(uint32(Cell.X)) << 32) | uint64(uint32(Cell.Y));
+}
+
+void FFighterSpatialGrid::Rebuild(const TArray<AThePunchCharacter*>& Fighters)
+{
+	// keep the allocations from last frame, the fighter count rarely changes
+	Entries.Reset();
+	Cells.Reset();
+
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		if (Fighter == NULL || Fighter->IsPendingKill())
+		{
+			continue;
+		}
+
+		const FVector Location = Fighter->GetActorLocation();
+
+		Entries.Add(FEntry{ Fighter, Location, MakeCellKey(GetCell(Location)) });
+	}
+
+	// group fighters of the same cell together so a cell is a single span
+	Entries.Sort([](const FEntry& A, const FEntry& B) { return A.CellKey < B.CellKey; });
+
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		FCellSpan* Span = Cells.Find(Entries[Index].CellKey);
+
+		if (Span)
+		{
+			++Span->Count;
+		}
+		else
+		{
+			Cells.Add(Entries[Index].CellKey, FCellSpan{ Index, 1 });
+		}
+	}
+}
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AThePunchCharacter;
+
+/**
+ * Uniform 2D grid over fighter locations, rebuilt once per frame.
+ * Fighters are sorted by cell so every cell is a contiguous span of Entries;
+ * a radius query only visits the cells overlapping its bounds.
+ */
+class THEPUNCH_API FFighterSpatialGrid
+{
+public:
+	struct FEntry
+	{
+		AThePunchCharacter* Fighter;
+		FVector Location;
+		uint64 CellKey;
+	};
+
+	explicit FFighterSpatialGrid(float InCellSize = 500.f);
+
+	// clears the grid and buckets every fighter by its current location
+	void Rebuild(const TArray<AThePunchCharacter*>& Fighters);
+
+	// appends every fighter within Radius of Origin (2D distance) to OutFighters
+	template<typename AllocatorType>
+	void QueryRadius(const FVector& Origin, float Radius, TArray<AThePunchCharacter*, AllocatorType>& OutFighters) const
+	{
+		const FIntPoint MinCell = GetCell(Origin - FVector(Radius, Radius, 0.f));
+		const FIntPoint MaxCell = GetCell(Origin + FVector(Radius, Radius, 0.f));
+		const float RadiusSquared = Radius * Radius;
+
+		for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+			{
+				const FCellSpan* Span = Cells.Find(MakeCellKey(FIntPoint(X, Y)));
+
+				if (Span == NULL)
+				{
+					continue;
+				}
+
+				for (int32 Index = Span->Start; Index < Span->Start + Span->Count; ++Index)
+				{
+					const FEntry& Entry = Entries[Index];
+
+					if (FVector::DistSquared2D(Entry.Location, Origin) <= RadiusSquared)
+					{
+						OutFighters.Add(Entry.Fighter);
+					}
+				}
+			}
+		}
+	}
+
+	// cell size in world units
+	float GetCellSize() const { return CellSize; }
+
+	// number of fighters indexed by the last rebuild
+	int32 Num() const { return Entries.Num(); }
+
+private:
+	// start index and count of a cell inside Entries
+	struct FCellSpan
+	{
+		int32 Start;
+		int32 Count;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+
+	static uint64 MakeCellKey(const FIntPoint& Cell);
+
+	float CellSize;
+
+	TArray<FEntry> Entries;
+
+	TMap<uint64, FCellSpan> Cells;
+};
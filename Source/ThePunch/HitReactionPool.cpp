@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HitReactionPool.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulated Hit Reactions"), STAT_SimulatedHitReactions, STATGROUP_ThePunch);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Canned Hit Reactions"), STAT_CannedHitReactions, STATGROUP_ThePunch);
+
+FHitReactionPool::FHitReactionPool()
+{
+	SetMaxSimulatedFighters(8);
+}
+
+void FHitReactionPool::SetMaxSimulatedFighters(int32 MaxFighters)
+{
+	MaxFighters = FMath::Max(MaxFighters, 0);
+
+	for (int32 Index = MaxFighters; Index < Slots.Num(); ++Index)
+	{
+		Release(Slots[Index], true);
+	}
+
+	Slots.SetNum(MaxFighters);
+}
+
+bool FHitReactionPool::Request(AThePunchCharacter* Fighter, EHitReaction Reaction, float Significance, float Duration, float WorldTime)
+{
+	FSlot* Target = NULL;
+
+	for (FSlot& Slot : Slots)
+	{
+		// a fighter that is hit again while reacting keeps its slot
+		if (Slot.Fighter.Get() == Fighter)
+		{
+			Target = &Slot;
+			break;
+		}
+
+		if (!Slot.Fighter.IsValid())
+		{
+			Target = &Slot;
+		}
+		else if (Target == NULL || (Target->Fighter.IsValid() && Slot.Significance < Target->Significance))
+		{
+			// remember the least significant reaction in case every slot is taken
+			Target = &Slot;
+		}
+	}
+
+	if (Target == NULL)
+	{
+		INC_DWORD_STAT(STAT_CannedHitReactions);
+		return false;
+	}
+
+	if (Target->Fighter.Get() == Fighter)
+	{
+		// a light hit does not cut a knockdown short, the reaction lasts until the later end
+		const float EndTime = FMath::Max(Target->StartTime + Target->Duration, WorldTime + Duration);
+
+		Target->Reaction = FMath::Max(Target->Reaction, Reaction);
+		Target->Significance = FMath::Max(Target->Significance, Significance);
+		Target->StartTime = WorldTime;
+		Target->Duration = EndTime - WorldTime;
+
+		return true;
+	}
+
+	if (Target->Fighter.IsValid())
+	{
+		if (Target->Significance >= Significance)
+		{
+			// everything simulating matters more than this hit
+			INC_DWORD_STAT(STAT_CannedHitReactions);
+			return false;
+		}
+
+		Release(*Target, true);
+	}
+
+	Target->Fighter = Fighter;
+	Target->Reaction = Reaction;
+	Target->Significance = Significance;
+	Target->StartTime = WorldTime;
+	Target->Duration = Duration;
+
+	return true;
+}
+
+void FHitReactionPool::Update(float WorldTime)
+{
+	int32 NumActive = 0;
+
+	for (FSlot& Slot : Slots)
+	{
+		AThePunchCharacter* Fighter = Slot.Fighter.Get();
+
+		if (Fighter == NULL)
+		{
+			continue;
+		}
+
+		const float Elapsed = WorldTime - Slot.StartTime;
+
+		if (Elapsed >= Slot.Duration)
+		{
+			Release(Slot, false);
+			continue;
+		}
+
+		// light hits fade from physics back to the animated pose
+		if (Slot.Reaction == EHitReaction::LIGHT)
+		{
+			Fighter->SetPhysicalHitReactionBlend(1.f - Elapsed / Slot.Duration);
+		}
+
+		++NumActive;
+	}
+
+	SET_DWORD_STAT(STAT_SimulatedHitReactions, NumActive);
+}
+
+void FHitReactionPool::Remove(AThePunchCharacter* Fighter)
+{
+	for (FSlot& Slot : Slots)
+	{
+		if (Slot.Fighter.Get() == Fighter)
+		{
+			Slot.Fighter.Reset();
+		}
+	}
+}
+
+int32 FHitReactionPool::GetNumActive() const
+{
+	int32 NumActive = 0;
+
+	for (const FSlot& Slot : Slots)
+	{
+		NumActive += Slot.Fighter.IsValid() ? 1 : 0;
+	}
+
+	return NumActive;
+}
+
+void FHitReactionPool::Release(FSlot& Slot, bool bFallBackToCanned)
+{
+	AThePunchCharacter* Fighter = Slot.Fighter.Get();
+
+	Slot.Fighter.Reset();
+
+	if (Fighter)
+	{
+		Fighter->StopPhysicalHitReaction();
+
+		if (bFallBackToCanned)
+		{
+			INC_DWORD_STAT(STAT_CannedHitReactions);
+			Fighter->PlayCannedHitReaction();
+		}
+	}
+}
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AThePunchCharacter;
+
+enum class EHitReaction : uint8
+{
+	// short physical-animation blend of the upper body
+	LIGHT,
+	// full ragdoll, the fighter gets back up when it ends
+	KNOCKDOWN
+};
+
+/**
+ * Fixed set of physics reaction slots shared by every fighter in the world.
+ * A reaction only simulates when it gets a slot; when all slots are taken the least
+ * significant reaction is pushed back to a canned animation, or the new one is
+ * refused, so the number of simulating fighters never exceeds the slot count.
+ */
+class THEPUNCH_API FHitReactionPool
+{
+public:
+	FHitReactionPool();
+
+	// resizes the pool; reactions in slots that go away fall back to canned animations
+	void SetMaxSimulatedFighters(int32 MaxFighters);
+
+	/**
+	* Request - asks for a physics slot for a reaction
+	* @param Fighter the victim
+	* @param Reaction light blend or knockdown
+	* @param Significance higher keeps the slot when the pool is full (closer, harder hits)
+	* @param Duration seconds the reaction simulates; a fighter already reacting keeps the stronger
+	*   reaction and the later end time
+	* @param WorldTime current world time
+	* @return true when the fighter may simulate; false means play a canned reaction instead
+	*/
+	bool Request(AThePunchCharacter* Fighter, EHitReaction Reaction, float Significance, float Duration, float WorldTime);
+
+	// ends finished reactions and fades light blends, call once per frame
+	void Update(float WorldTime);
+
+	// drops the fighter's reaction without touching the fighter, used when it leaves the world
+	void Remove(AThePunchCharacter* Fighter);
+
+	// number of fighters simulating right now
+	int32 GetNumActive() const;
+
+private:
+	struct FSlot
+	{
+		TWeakObjectPtr<AThePunchCharacter> Fighter;
+		EHitReaction Reaction;
+		float Significance;
+		float StartTime;
+		float Duration;
+	};
+
+	// stops the slot's simulation and frees it
+	void Release(FSlot& Slot, bool bFallBackToCanned);
+
+	TArray<FSlot> Slots;
+};
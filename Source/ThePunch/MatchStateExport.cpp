@@ -0,0 +1,412 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MatchStateExport.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "CombatBenchmarks.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Crc.h"
+
+DECLARE_CYCLE_STAT(TEXT("Publish Match State"), STAT_PublishMatchState, STATGROUP_ThePunch);
+
+// the checksum covers everything after itself, unused entries included
+static uint32 ComputeChecksum(const FMatchStateSlot& Slot)
+{
+	return FCrc::MemCrc32(&Slot.Frame, sizeof(FMatchStateSlot) - STRUCT_OFFSET(FMatchStateSlot, Frame));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMatchStateExport
+
+FMatchStateExport::FMatchStateExport()
+	: Region(NULL)
+	, Layout(NULL)
+	, Frame(0)
+	, NumHits(0)
+	, bReportedTruncation(false)
+{
+	FMemory::Memzero(Hits, sizeof(Hits));
+}
+
+FMatchStateExport::~FMatchStateExport()
+{
+	Close();
+}
+
+FString FMatchStateExport::GetRegionName()
+{
+	FString Name = TEXT("ThePunchMatchState");
+	FParse::Value(FCommandLine::Get(), TEXT("MatchStateExport="), Name);
+
+	return Name;
+}
+
+bool FMatchStateExport::IsExportRequested()
+{
+	FString Name;
+
+	return FParse::Param(FCommandLine::Get(), TEXT("MatchStateExport")) || FParse::Value(FCommandLine::Get(), TEXT("MatchStateExport="), Name);
+}
+
+bool FMatchStateExport::Open(const FString& Name)
+{
+	Close();
+
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, true, FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write, sizeof(FMatchStateLayout));
+
+	if (Region == NULL)
+	{
+		UE_LOG(LogThePunch, Warning, TEXT("Could not create the match state region %s"), *Name);
+		return false;
+	}
+
+	Layout = static_cast<FMatchStateLayout*>(Region->GetAddress());
+	FMemory::Memzero(Layout, sizeof(FMatchStateLayout));
+
+	bReportedTruncation = false;
+
+	Layout->Header.HeaderSize = sizeof(FMatchStateHeader);
+	Layout->Header.SlotSize = sizeof(FMatchStateSlot);
+	Layout->Header.SlotCount = MatchState::SlotCount;
+	Layout->Header.MaxFighters = MatchState::MaxFighters;
+	Layout->Header.MaxHits = MatchState::MaxHits;
+	Layout->Header.Version = MatchState::Version;
+
+	// readers check the magic last, it tells them the header is complete
+	FPlatformMisc::MemoryBarrier();
+	Layout->Header.Magic = MatchState::Magic;
+
+	UE_LOG(LogThePunch, Log, TEXT("Publishing match state to shared memory region %s (%d bytes)"), *Name, (int32)sizeof(FMatchStateLayout));
+
+	return true;
+}
+
+void FMatchStateExport::Close()
+{
+	if (Region)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	}
+
+	Region = NULL;
+	Layout = NULL;
+}
+
+void FMatchStateExport::RecordHit(const AThePunchCharacter* Attacker, const AThePunchCharacter* Victim, const FVector& Location, float WorldTime)
+{
+	FMatchStateHit& Hit = Hits[NumHits % MatchState::MaxHits];
+
+	Hit.AttackerId = Attacker ? Attacker->GetUniqueID() : 0;
+	Hit.VictimId = Victim ? Victim->GetUniqueID() : 0;
+	Hit.WorldTime = WorldTime;
+	Hit.Location[0] = Location.X;
+	Hit.Location[1] = Location.Y;
+	Hit.Location[2] = Location.Z;
+
+	++NumHits;
+}
+
+void FMatchStateExport::Publish(const TArray<AThePunchCharacter*>& Fighters, double WorldTime)
+{
+	if (Layout == NULL)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PublishMatchState);
+
+	++Frame;
+
+	FMatchStateSlot& Slot = Layout->Slots[Frame % MatchState::SlotCount];
+
+	// odd sequence: readers of this slot throw their copy away
+	const int32 Sequence = Slot.Sequence + 1;
+	FPlatformAtomics::InterlockedExchange(&Slot.Sequence, Sequence);
+
+	Slot.Frame = Frame;
+	Slot.WorldTime = WorldTime;
+	Slot.NumFighters = FMath::Min(Fighters.Num(), (int32)MatchState::MaxFighters);
+	Slot.NumFightersInMatch = Fighters.Num();
+	Slot.Reserved = 0;
+
+	if (Slot.NumFighters < Slot.NumFightersInMatch && !bReportedTruncation)
+	{
+		UE_LOG(LogThePunch, Warning, TEXT("Match state only holds %d of the %d fighters, observers see NumFightersInMatch"), (int32)MatchState::MaxFighters, Fighters.Num());
+		bReportedTruncation = true;
+	}
+
+	for (uint32 Index = 0; Index < Slot.NumFighters; ++Index)
+	{
+		AThePunchCharacter* Fighter = Fighters[Index];
+		FMatchStateFighter& Entry = Slot.Fighters[Index];
+
+		const FVector Location = Fighter->GetActorLocation();
+		const FQuat Rotation = Fighter->GetActorQuat();
+
+		Entry.Id = Fighter->GetUniqueID();
+		Entry.CurrentAttack = (uint8)Fighter->GetCurrentAttack();
+		Entry.Flags = (Fighter->GetIsAttackWindowOpen() ? MatchState::ATTACK_WINDOW_OPEN : 0)
+			| (Fighter->GetCharacterMovement()->IsFalling() ? MatchState::IN_AIR : 0)
+			| (Fighter->IsSimulatingHitReaction() ? MatchState::HIT_REACTION : 0);
+		Entry.Reserved = 0;
+		Entry.Location[0] = Location.X;
+		Entry.Location[1] = Location.Y;
+		Entry.Location[2] = Location.Z;
+		Entry.Rotation[0] = Rotation.X;
+		Entry.Rotation[1] = Rotation.Y;
+		Entry.Rotation[2] = Rotation.Z;
+		Entry.Rotation[3] = Rotation.W;
+	}
+
+	// copy the hit ring out oldest first
+	Slot.NumHits = FMath::Min(NumHits, (uint32)MatchState::MaxHits);
+
+	for (uint32 Index = 0; Index < Slot.NumHits; ++Index)
+	{
+		Slot.Hits[Index] = Hits[(NumHits - Slot.NumHits + Index) % MatchState::MaxHits];
+	}
+
+	Slot.Checksum = ComputeChecksum(Slot);
+
+	// even sequence: the slot is complete, then point readers at it
+	FPlatformAtomics::InterlockedExchange(&Slot.Sequence, Sequence + 1);
+	FPlatformAtomics::InterlockedExchange(&Layout->Header.LatestFrame, (int64)Frame);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FMatchStateReader
+
+FMatchStateReader::FMatchStateReader()
+	: Region(NULL)
+	, Layout(NULL)
+{
+}
+
+FMatchStateReader::~FMatchStateReader()
+{
+	Close();
+}
+
+bool FMatchStateReader::Open(const FString& Name)
+{
+	Close();
+
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, false, FPlatformMemory::ESharedMemoryAccess::Read, sizeof(FMatchStateLayout));
+
+	if (Region == NULL)
+	{
+		return false;
+	}
+
+	Layout = static_cast<const FMatchStateLayout*>(Region->GetAddress());
+	RegionName = Name;
+
+	const FMatchStateHeader& Header = Layout->Header;
+
+	if (Header.Magic != MatchState::Magic || Header.Version != MatchState::Version || Header.SlotSize != sizeof(FMatchStateSlot) || Header.SlotCount != MatchState::SlotCount)
+	{
+		UE_LOG(LogThePunch, Warning, TEXT("Match state region %s has an unknown layout (version %d)"), *Name, Header.Version);
+
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FMatchStateReader::Close()
+{
+	if (Region)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	}
+
+	Region = NULL;
+	Layout = NULL;
+	RegionName.Empty();
+}
+
+bool FMatchStateReader::ReadLatest(FMatchStateSlot& OutSlot, int32& OutRetries) const
+{
+	OutRetries = 0;
+
+	if (Layout == NULL)
+	{
+		return false;
+	}
+
+	for (int32 Attempt = 0; Attempt < 8; ++Attempt)
+	{
+		const int64 LatestFrame = Layout->Header.LatestFrame;
+
+		if (LatestFrame == 0)
+		{
+			return false;
+		}
+
+		const FMatchStateSlot& Slot = Layout->Slots[LatestFrame % MatchState::SlotCount];
+		const int32 Before = Slot.Sequence;
+
+		FPlatformMisc::MemoryBarrier();
+
+		if ((Before & 1) == 0)
+		{
+			FMemory::Memcpy(&OutSlot, (const void*)&Slot, sizeof(FMatchStateSlot));
+
+			FPlatformMisc::MemoryBarrier();
+
+			// the writer did not touch the slot while it was copied
+			if (Slot.Sequence == Before && OutSlot.Frame == (uint64)LatestFrame)
+			{
+				return true;
+			}
+		}
+
+		++OutRetries;
+	}
+
+	return false;
+}
+
+bool FMatchStateReader::IsConsistent(const FMatchStateSlot& Slot)
+{
+	return Slot.NumFighters <= MatchState::MaxFighters && Slot.NumFighters <= Slot.NumFightersInMatch && Slot.NumHits <= MatchState::MaxHits
+		&& Slot.Checksum == ComputeChecksum(Slot);
+}
+
+bool FMatchStateReader::Verify(float Seconds) const
+{
+	FMatchStateSlot* Slot = new FMatchStateSlot;
+
+	int64 Reads = 0;
+	int64 Frames = 0;
+	int64 Retries = 0;
+	int64 Failures = 0;
+	int64 Inconsistent = 0;
+	int64 Truncated = 0;
+	uint64 LastFrame = 0;
+
+	const double EndTime = FPlatformTime::Seconds() + Seconds;
+
+	while (FPlatformTime::Seconds() < EndTime)
+	{
+		int32 SlotRetries = 0;
+
+		if (ReadLatest(*Slot, SlotRetries))
+		{
+			++Reads;
+
+			if (!IsConsistent(*Slot))
+			{
+				++Inconsistent;
+			}
+
+			if (Slot->Frame != LastFrame)
+			{
+				++Frames;
+				LastFrame = Slot->Frame;
+
+				if (Slot->NumFighters < Slot->NumFightersInMatch)
+				{
+					++Truncated;
+				}
+			}
+		}
+		else
+		{
+			++Failures;
+		}
+
+		Retries += SlotRetries;
+
+		FPlatformProcess::Sleep(0.f);
+	}
+
+	delete Slot;
+
+	UE_LOG(LogThePunch, Display, TEXT("Match state %s: %lld reads, %lld frames (%lld truncated), %lld torn reads retried, %lld failed reads, %lld inconsistent"),
+		*RegionName, Reads, Frames, Truncated, Retries, Failures, Inconsistent);
+
+	return Inconsistent == 0 && Frames > 0;
+}
+
+#if !UE_BUILD_SHIPPING
+
+// reads the region as fast as possible, meant to run in a second process next to a busy game
+static void VerifyMatchState(const TArray<FString>& Args)
+{
+	const float Seconds = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 10.f;
+	const FString Name = Args.Num() > 1 ? Args[1] : FMatchStateExport::GetRegionName();
+
+	FMatchStateReader Reader;
+
+	if (!Reader.Open(Name))
+	{
+		UE_LOG(LogThePunch, Error, TEXT("No match state region %s, start the game with -MatchStateExport"), *Name);
+		return;
+	}
+
+	const bool bPassed = Reader.Verify(Seconds);
+
+	if (Args.Contains(TEXT("exit")))
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+	}
+}
+
+static FAutoConsoleCommand VerifyMatchStateCommand(
+	TEXT("ThePunch.MatchState.Verify"),
+	TEXT("Reads the match state region and checks every snapshot. Args: [seconds] [region name] [exit]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&VerifyMatchState));
+
+// publishing a full slot of fighters has to stay in the microseconds
+static FCombatBenchmarkResult BenchmarkPublishMatchState(UWorld* World)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TArray<AThePunchCharacter*> Fighters;
+
+	for (int32 Index = 0; Index < MatchState::MaxFighters; ++Index)
+	{
+		AThePunchCharacter* Fighter = World->SpawnActor<AThePunchCharacter>(AThePunchCharacter::StaticClass(), FVector(Index * 200.f, 1000.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+
+		if (Fighter)
+		{
+			Fighters.Add(Fighter);
+		}
+	}
+
+	FMatchStateExport Export;
+	Export.Open(TEXT("ThePunchMatchStateBenchmark"));
+
+	const FCombatBenchmarkResult Result = FCombatBenchmarks::Measure(TEXT("MatchState.Publish"), 10000, [&Export, &Fighters]()
+	{
+		Export.RecordHit(NULL, NULL, FVector::ZeroVector, 0.f);
+		Export.Publish(Fighters, 0.0);
+	});
+
+	Export.Close();
+
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		Fighter->Destroy();
+	}
+
+	return Result;
+}
+
+static struct FRegisterMatchStateBenchmark
+{
+	FRegisterMatchStateBenchmark()
+	{
+		FCombatBenchmarks::GetExtraBenchmarks().Add(&BenchmarkPublishMatchState);
+	}
+} RegisterMatchStateBenchmark;
+
+#endif
@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformMemory.h"
+
+class AThePunchCharacter;
+
+/**
+ * Layout of the match state shared memory region, version MatchStateVersion.
+ * Observers map the region read only and never take a lock:
+ *   Header | Slots[SlotCount]
+ * The game publishes one slot per frame, round robin, and bumps Header.LatestFrame once
+ * the slot is complete. Each slot is a seqlock: Sequence is odd while the slot is written;
+ * a reader copies the slot and keeps the copy only when Sequence was even and unchanged
+ * around the copy. Checksum (CRC32 of everything after it) catches anything else.
+ * A match with more than MaxFighters fighters only exports the first MaxFighters; the slot's
+ * NumFightersInMatch is then larger than NumFighters.
+ * All values are little endian, locations in centimeters, times in world seconds.
+ */
+namespace MatchState
+{
+	static const uint32 Magic = 0x534d5054; // "TPMS"
+	static const uint16 Version = 2;
+
+	enum { SlotCount = 4 };
+	enum { MaxFighters = 64 };
+	enum { MaxHits = 16 };
+
+	enum EFighterFlags
+	{
+		ATTACK_WINDOW_OPEN = 1 << 0,
+		IN_AIR = 1 << 1,
+		HIT_REACTION = 1 << 2
+	};
+}
+
+struct FMatchStateFighter
+{
+	// UObject unique id, stable while the fighter exists
+	uint32 Id;
+
+	// EAttackType of the last attack
+	uint8 CurrentAttack;
+
+	// MatchState::EFighterFlags
+	uint8 Flags;
+
+	uint16 Reserved;
+
+	float Location[3];
+
+	// rotation quaternion X, Y, Z, W
+	float Rotation[4];
+};
+
+struct FMatchStateHit
+{
+	uint32 AttackerId;
+
+	uint32 VictimId;
+
+	float WorldTime;
+
+	float Location[3];
+};
+
+struct FMatchStateSlot
+{
+	volatile int32 Sequence;
+
+	uint32 Checksum;
+
+	uint64 Frame;
+
+	double WorldTime;
+
+	uint32 NumFighters;
+
+	// the most recent hits, oldest first
+	uint32 NumHits;
+
+	// every fighter of the match, more than NumFighters when the slot was truncated
+	uint32 NumFightersInMatch;
+
+	uint32 Reserved;
+
+	FMatchStateFighter Fighters[MatchState::MaxFighters];
+
+	FMatchStateHit Hits[MatchState::MaxHits];
+};
+
+struct FMatchStateHeader
+{
+	uint32 Magic;
+
+	uint16 Version;
+
+	uint16 HeaderSize;
+
+	uint32 SlotSize;
+
+	uint32 SlotCount;
+
+	uint32 MaxFighters;
+
+	uint32 MaxHits;
+
+	// frame of the newest complete slot, 0 before the first publish
+	volatile int64 LatestFrame;
+};
+
+struct FMatchStateLayout
+{
+	FMatchStateHeader Header;
+
+	FMatchStateSlot Slots[MatchState::SlotCount];
+};
+
+/**
+ * Game side of the region. Publish writes straight into the next slot, so the cost is
+ * one pass over the fighters and a CRC of the slot.
+ */
+class THEPUNCH_API FMatchStateExport
+{
+public:
+	FMatchStateExport();
+
+	~FMatchStateExport();
+
+	/** creates the named region, returns false when the platform has no shared memory **/
+	bool Open(const FString& Name);
+
+	void Close();
+
+	bool IsOpen() const { return Region != NULL; }
+
+	// writes a snapshot of the fighters and the recent hits into the next slot
+	void Publish(const TArray<AThePunchCharacter*>& Fighters, double WorldTime);
+
+	// remembers a hit for the next snapshots
+	void RecordHit(const AThePunchCharacter* Attacker, const AThePunchCharacter* Victim, const FVector& Location, float WorldTime);
+
+	// name of the region, from -MatchStateExport=<name> or the default
+	static FString GetRegionName();
+
+	/** true when the command line asks for the export **/
+	static bool IsExportRequested();
+
+private:
+	FPlatformMemory::FSharedMemoryRegion* Region;
+
+	FMatchStateLayout* Layout;
+
+	uint64 Frame;
+
+	// ring of the last MaxHits hits
+	FMatchStateHit Hits[MatchState::MaxHits];
+
+	uint32 NumHits;
+
+	// the truncation warning is logged once per region
+	bool bReportedTruncation;
+};
+
+/** Observer side, maps the region read only and copies out consistent snapshots. */
+class THEPUNCH_API FMatchStateReader
+{
+public:
+	FMatchStateReader();
+
+	~FMatchStateReader();
+
+	/** maps the region, returns false when it does not exist or has another version **/
+	bool Open(const FString& Name);
+
+	void Close();
+
+	/**
+	* ReadLatest - copies the newest complete slot
+	* @param OutSlot the snapshot
+	* @param OutRetries number of torn reads that were retried
+	* @return false when nothing was published yet or the writer kept overwriting the slot
+	*/
+	bool ReadLatest(FMatchStateSlot& OutSlot, int32& OutRetries) const;
+
+	// checks the counts and the checksum of a copied slot
+	static bool IsConsistent(const FMatchStateSlot& Slot);
+
+	/**
+	* Verify - reads the region as fast as possible and checks every snapshot
+	* @param Seconds how long to read for
+	* @return true when frames were read and every one of them was consistent
+	*/
+	bool Verify(float Seconds) const;
+
+private:
+	FPlatformMemory::FSharedMemoryRegion* Region;
+
+	const FMatchStateLayout* Layout;
+
+	FString RegionName;
+};
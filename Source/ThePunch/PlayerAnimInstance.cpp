@@ -1,15 +1,39 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "PlayerAnimInstance.h"
+#include "ThePunch.h"
 #include "ThePunchCharacter.h"
+#include "CombatBenchmarks.h"
 #include "GameFramework/PawnMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "Components/SkeletalMeshComponent.h"
 #include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/BlendSpaceBase.h"
+#include "AnimationRuntime.h"
+#include "UObject/ConstructorHelpers.h"
 
 UPlayerAnimInstance::UPlayerAnimInstance()
 {
 	IsInAir = false;
 	IsAnimationBlended = true;
 	Speed = 0.f;
+
+	// the same assets as the ThirdPerson_AnimBP graph
+	static ConstructorHelpers::FObjectFinder<UBlendSpaceBase> IdleRun(TEXT("/Game/Mannequin/Animations/ThirdPerson_IdleRun_2D"));
+	static ConstructorHelpers::FObjectFinder<UAnimSequence> JumpStart(TEXT("/Game/Mannequin/Animations/ThirdPersonJump_Start"));
+	static ConstructorHelpers::FObjectFinder<UAnimSequence> JumpLoop(TEXT("/Game/Mannequin/Animations/ThirdPersonJump_Loop"));
+	static ConstructorHelpers::FObjectFinder<UAnimSequence> JumpEnd(TEXT("/Game/Mannequin/Animations/ThirdPersonJump_End"));
+
+	bUseNativeGraph = true;
+	LocomotionBlendSpace = IdleRun.Object;
+	JumpStartSequence = JumpStart.Object;
+	JumpLoopSequence = JumpLoop.Object;
+	JumpEndSequence = JumpEnd.Object;
+	MontageSlotName = FName(TEXT("DefaultSlot"));
+	UpperBodyBone = FName(TEXT("spine_01"));
+	StateBlendTime = 0.2f;
 }
 
 void UPlayerAnimInstance::NativeInitializeAnimation()
@@ -41,12 +65,373 @@ void UPlayerAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
 			IsInAir = PlayerCharacter->GetMovementComponent()->IsFalling();
 			IsAnimationBlended = PlayerCharacter->GetIsAnimationBlended();
 			Speed = PlayerCharacter->GetVelocity().Size();
+
+			// only build the debug text when it will be printed
+			if (PlayerCharacter->IsLogEnabled(ELogLevel::TRACE))
+			{
+				GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Yellow, "IsInAir " + FString(IsInAir ? "True" : "False"));
+				GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Yellow, "IsAnimationBlended " + FString(IsAnimationBlended ? "True" : "False"));
+				GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Yellow, "Speed " + FString::SanitizeFloat(Speed));
+			}
 		}
+	}
+}
+
+FAnimInstanceProxy* UPlayerAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FPlayerAnimInstanceProxy(this);
+}
+
+void UPlayerAnimInstance::DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy)
+{
+	delete static_cast<FPlayerAnimInstanceProxy*>(InProxy);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FPlayerAnimInstanceProxy
+
+FPlayerAnimInstanceProxy::FPlayerAnimInstanceProxy()
+	: FAnimInstanceProxy()
+{
+}
+
+FPlayerAnimInstanceProxy::FPlayerAnimInstanceProxy(UAnimInstance* InAnimInstance)
+	: FAnimInstanceProxy(InAnimInstance)
+	, bUseNativeGraph(false)
+	, bIsInAir(false)
+	, bIsAnimationBlended(true)
+	, Speed(0.f)
+	, StateBlendTime(0.2f)
+	, State(EPlayerLocomotionState::GROUND)
+	, PreviousState(EPlayerLocomotionState::GROUND)
+	, StateBlendAlpha(1.f)
+	, bNodesInitialized(false)
+	, SlotNodeWeight(0.f)
+	, SlotSourceWeight(1.f)
+	, SlotTotalNodeWeight(0.f)
+{
+}
+
+void FPlayerAnimInstanceProxy::Initialize(UAnimInstance* InAnimInstance)
+{
+	FAnimInstanceProxy::Initialize(InAnimInstance);
 
-		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Yellow, "IsInAir " + FString(IsInAir ? "True" : "False"));
-		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Yellow, "IsAnimationBlended " + FString(IsAnimationBlended ? "True" : "False"));
-		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Yellow, "Speed " + FString::SanitizeFloat(Speed));
+	const UPlayerAnimInstance* AnimInstance = CastChecked<UPlayerAnimInstance>(InAnimInstance);
+
+	LocomotionPlayer.BlendSpace = AnimInstance->LocomotionBlendSpace;
+	LocomotionPlayer.bLoop = true;
+
+	JumpStartPlayer.Sequence = AnimInstance->JumpStartSequence;
+	JumpStartPlayer.bLoopAnimation = false;
+
+	JumpLoopPlayer.Sequence = AnimInstance->JumpLoopSequence;
+	JumpLoopPlayer.bLoopAnimation = true;
+
+	JumpEndPlayer.Sequence = AnimInstance->JumpEndSequence;
+	JumpEndPlayer.bLoopAnimation = false;
+
+	MontageSlotName = AnimInstance->MontageSlotName;
+	UpperBodyBone = AnimInstance->UpperBodyBone;
+	StateBlendTime = FMath::Max(AnimInstance->StateBlendTime, KINDA_SMALL_NUMBER);
+
+	// montages only reach the native graph through a registered slot
+	RegisterSlotNodeWithAnimInstance(MontageSlotName);
+
+	bNodesInitialized = false;
+}
+
+void FPlayerAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	const UPlayerAnimInstance* AnimInstance = CastChecked<UPlayerAnimInstance>(InAnimInstance);
+
+	bUseNativeGraph = AnimInstance->bUseNativeGraph && AnimInstance->LocomotionBlendSpace != NULL;
+	bIsInAir = AnimInstance->IsInAir;
+	bIsAnimationBlended = AnimInstance->IsAnimationBlended;
+	Speed = AnimInstance->Speed;
+}
+
+void FPlayerAnimInstanceProxy::UpdateAnimationNode(float DeltaSeconds)
+{
+	// the native nodes were already updated in Update
+	if (!bUseNativeGraph)
+	{
+		FAnimInstanceProxy::UpdateAnimationNode(DeltaSeconds);
 	}
 }
 
+void FPlayerAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	FAnimInstanceProxy::Update(DeltaSeconds);
+
+	if (!bUseNativeGraph)
+	{
+		return;
+	}
+
+	if (!bNodesInitialized)
+	{
+		const FAnimationInitializeContext InitContext(this);
+
+		LocomotionPlayer.Initialize_AnyThread(InitContext);
+		JumpStartPlayer.Initialize_AnyThread(InitContext);
+		JumpLoopPlayer.Initialize_AnyThread(InitContext);
+		JumpEndPlayer.Initialize_AnyThread(InitContext);
+
+		bNodesInitialized = true;
+	}
+
+	// same transitions as the jump state machine of the Blueprint graph
+	switch (State)
+	{
+	case EPlayerLocomotionState::GROUND:
+		if (bIsInAir)
+		{
+			SetState(EPlayerLocomotionState::JUMP_START);
+		}
+		break;
+	case EPlayerLocomotionState::JUMP_START:
+		if (!bIsInAir)
+		{
+			SetState(EPlayerLocomotionState::JUMP_END);
+		}
+		else if (IsStateFinishing(State))
+		{
+			SetState(EPlayerLocomotionState::JUMP_LOOP);
+		}
+		break;
+	case EPlayerLocomotionState::JUMP_LOOP:
+		if (!bIsInAir)
+		{
+			SetState(EPlayerLocomotionState::JUMP_END);
+		}
+		break;
+	case EPlayerLocomotionState::JUMP_END:
+		if (bIsInAir)
+		{
+			SetState(EPlayerLocomotionState::JUMP_START);
+		}
+		else if (Speed > 10.f || IsStateFinishing(State))
+		{
+			SetState(EPlayerLocomotionState::GROUND);
+		}
+		break;
+	default:
+		break;
+	}
+
+	StateBlendAlpha = FMath::Min(StateBlendAlpha + DeltaSeconds / StateBlendTime, 1.f);
+
+	LocomotionPlayer.X = Speed;
+
+	const FAnimationUpdateContext UpdateContext(this, DeltaSeconds);
+
+	GetStatePlayer(State).Update_AnyThread(UpdateContext.FractionalWeight(StateBlendAlpha));
+
+	if (StateBlendAlpha < 1.f && &GetStatePlayer(PreviousState) != &GetStatePlayer(State))
+	{
+		GetStatePlayer(PreviousState).Update_AnyThread(UpdateContext.FractionalWeight(1.f - StateBlendAlpha));
+	}
+
+	// what FAnimNode_Slot does for the Blueprint graph
+	GetSlotWeight(MontageSlotName, SlotNodeWeight, SlotSourceWeight, SlotTotalNodeWeight);
+	UpdateSlotNodeWeight(MontageSlotName, SlotNodeWeight, 1.f);
+}
+
+bool FPlayerAnimInstanceProxy::Evaluate(FPoseContext& Output)
+{
+	if (!bUseNativeGraph || !bNodesInitialized)
+	{
+		return false;
+	}
+
+	FPoseContext SourcePose(Output);
+	GetStatePlayer(State).Evaluate_AnyThread(SourcePose);
+
+	if (StateBlendAlpha < 1.f && &GetStatePlayer(PreviousState) != &GetStatePlayer(State))
+	{
+		FPoseContext PreviousPose(Output);
+		GetStatePlayer(PreviousState).Evaluate_AnyThread(PreviousPose);
+
+		FPoseContext CurrentPose(Output);
+		CurrentPose.Pose = SourcePose.Pose;
+		CurrentPose.Curve = SourcePose.Curve;
+
+		FAnimationRuntime::BlendTwoPosesTogether(CurrentPose.Pose, PreviousPose.Pose, CurrentPose.Curve, PreviousPose.Curve, StateBlendAlpha, SourcePose.Pose, SourcePose.Curve);
+	}
+
+	if (SlotNodeWeight <= ZERO_ANIMWEIGHT_THRESH)
+	{
+		Output.Pose = SourcePose.Pose;
+		Output.Curve = SourcePose.Curve;
+		return true;
+	}
+
+	FPoseContext SlotPose(Output);
+	SlotEvaluatePose(MontageSlotName, SourcePose.Pose, SourcePose.Curve, SlotSourceWeight, SlotPose.Pose, SlotPose.Curve, SlotNodeWeight, SlotTotalNodeWeight);
+
+	// kicks play on the whole body, punches only above UpperBodyBone so the legs keep moving
+	if (!bIsAnimationBlended || !BuildUpperBodyWeights())
+	{
+		Output.Pose = SlotPose.Pose;
+		Output.Curve = SlotPose.Curve;
+		return true;
+	}
+
+	Output.Pose = SourcePose.Pose;
+	Output.Curve = SlotPose.Curve;
+
+	for (FCompactPoseBoneIndex BoneIndex : Output.Pose.ForEachBoneIndex())
+	{
+		const float Weight = UpperBodyWeights[BoneIndex.GetInt()];
+
+		if (Weight > 0.f)
+		{
+			Output.Pose[BoneIndex].Blend(SourcePose.Pose[BoneIndex], SlotPose.Pose[BoneIndex], Weight);
+		}
+	}
+
+	return true;
+}
+
+void FPlayerAnimInstanceProxy::SetState(EPlayerLocomotionState NewState)
+{
+	PreviousState = State;
+	State = NewState;
+	StateBlendAlpha = 0.f;
+
+	// jump sequences restart on every entry, locomotion keeps its phase
+	if (NewState != EPlayerLocomotionState::GROUND)
+	{
+		GetStatePlayer(NewState).Initialize_AnyThread(FAnimationInitializeContext(this));
+	}
+}
+
+FAnimNode_AssetPlayerBase& FPlayerAnimInstanceProxy::GetStatePlayer(EPlayerLocomotionState InState)
+{
+	switch (InState)
+	{
+	case EPlayerLocomotionState::JUMP_START:
+		return JumpStartPlayer.Sequence ? (FAnimNode_AssetPlayerBase&)JumpStartPlayer : LocomotionPlayer;
+	case EPlayerLocomotionState::JUMP_LOOP:
+		return JumpLoopPlayer.Sequence ? (FAnimNode_AssetPlayerBase&)JumpLoopPlayer : LocomotionPlayer;
+	case EPlayerLocomotionState::JUMP_END:
+		return JumpEndPlayer.Sequence ? (FAnimNode_AssetPlayerBase&)JumpEndPlayer : LocomotionPlayer;
+	default:
+		return LocomotionPlayer;
+	}
+}
+
+bool FPlayerAnimInstanceProxy::IsStateFinishing(EPlayerLocomotionState InState)
+{
+	FAnimNode_AssetPlayerBase& Player = GetStatePlayer(InState);
+
+	// a state without its own sequence finishes right away
+	if (&Player == &LocomotionPlayer)
+	{
+		return true;
+	}
+
+	return Player.GetCurrentAssetLength() - Player.GetCurrentAssetTime() <= StateBlendTime;
+}
+
+bool FPlayerAnimInstanceProxy::BuildUpperBodyWeights()
+{
+	const FBoneContainer& RequiredBones = GetRequiredBones();
+	const int32 MeshBoneIndex = RequiredBones.GetPoseBoneIndexForBoneName(UpperBodyBone);
+
+	if (MeshBoneIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FCompactPoseBoneIndex UpperBodyIndex = RequiredBones.MakeCompactPoseIndex(FMeshPoseBoneIndex(MeshBoneIndex));
+	const int32 NumBones = RequiredBones.GetCompactPoseNumBones();
+
+	UpperBodyWeights.Reset(NumBones);
+	UpperBodyWeights.AddZeroed(NumBones);
+
+	// parents come before their children in a compact pose, one pass is enough
+	for (int32 Index = 0; Index < NumBones; ++Index)
+	{
+		const FCompactPoseBoneIndex BoneIndex(Index);
+
+		if (BoneIndex == UpperBodyIndex)
+		{
+			UpperBodyWeights[Index] = 1.f;
+		}
+		else if (Index > 0)
+		{
+			UpperBodyWeights[Index] = UpperBodyWeights[RequiredBones.GetParentBoneIndex(BoneIndex).GetInt()];
+		}
+	}
+
+	return true;
+}
+
+#if !UE_BUILD_SHIPPING
+
+// ticks and evaluates one fighter's animation, with the Blueprint graph or the native one
+static FCombatBenchmarkResult BenchmarkFighterAnimation(UWorld* World, bool bNativeGraph)
+{
+	const TCHAR* Name = bNativeGraph ? TEXT("Anim.Fighter.Native") : TEXT("Anim.Fighter.Blueprint");
+
+	// the default pawn is the Blueprint with the mesh and the anim class
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* FighterClass = GameMode && GameMode->DefaultPawnClass ? *GameMode->DefaultPawnClass : AThePunchCharacter::StaticClass();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AThePunchCharacter* Fighter = World->SpawnActor<AThePunchCharacter>(FighterClass, FVector(0.f, 1000.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+	USkeletalMeshComponent* Mesh = Fighter ? Fighter->GetMesh() : NULL;
+	UPlayerAnimInstance* AnimInstance = Mesh ? Cast<UPlayerAnimInstance>(Mesh->GetAnimInstance()) : NULL;
+
+	if (AnimInstance == NULL)
+	{
+		if (Fighter)
+		{
+			Fighter->Destroy();
+		}
+
+		UE_LOG(LogThePunch, Warning, TEXT("%s needs a default pawn with a UPlayerAnimInstance"), Name);
+
+		FCombatBenchmarkResult Result;
+		Result.Name = Name;
+		Result.NsPerOp = 0.0;
+		Result.AllocsPerOp = 0.0;
+		Result.BytesPerOp = 0.0;
+		return Result;
+	}
+
+	// the fighter already swapped in the native class, the Blueprint variant puts the mesh's own class back
+	if (!bNativeGraph)
+	{
+		const AThePunchCharacter* FighterDefaults = FighterClass->GetDefaultObject<AThePunchCharacter>();
+		UClass* BlueprintAnimClass = FighterDefaults->GetMesh()->AnimClass;
+
+		Mesh->SetAnimInstanceClass(BlueprintAnimClass);
+	}
+
+	FCombatBenchmarkResult Result = FCombatBenchmarks::Measure(Name, 1000, [Mesh]()
+	{
+		Mesh->TickAnimation(1.f / 60.f, false);
+		Mesh->RefreshBoneTransforms();
+	});
+
+	Fighter->Destroy();
+
+	return Result;
+}
+
+static struct FRegisterAnimationBenchmarks
+{
+	FRegisterAnimationBenchmarks()
+	{
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkFighterAnimation(World, false); });
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkFighterAnimation(World, true); });
+	}
+} RegisterAnimationBenchmarks;
 
+#endif
@@ -4,8 +4,104 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Animation/AnimNode_SequencePlayer.h"
+#include "AnimNodes/AnimNode_BlendSpacePlayer.h"
 #include "PlayerAnimInstance.generated.h"
 
+class UBlendSpaceBase;
+class UAnimSequence;
+
+// states of the native locomotion graph
+enum class EPlayerLocomotionState : uint8
+{
+	GROUND,
+	JUMP_START,
+	JUMP_LOOP,
+	JUMP_END
+};
+
+/**
+ * Native version of the ThirdPerson_AnimBP graph: idle/walk/run blend space, jump
+ * start/loop/end states and the montage slot, blended on the upper body only while
+ * the player's animation is blended. Updates and evaluates on the animation worker
+ * threads without touching the Blueprint VM.
+ */
+USTRUCT()
+struct THEPUNCH_API FPlayerAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+public:
+	FPlayerAnimInstanceProxy();
+
+	FPlayerAnimInstanceProxy(UAnimInstance* InAnimInstance);
+
+	virtual void Initialize(UAnimInstance* InAnimInstance) override;
+
+	// copies the game thread values, runs before Update
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+
+	virtual void Update(float DeltaSeconds) override;
+
+	// returns false when the native graph is off, the Blueprint graph evaluates then
+	virtual bool Evaluate(FPoseContext& Output) override;
+
+protected:
+	// the Blueprint anim graph of a child class is only updated while the native graph is off
+	virtual void UpdateAnimationNode(float DeltaSeconds) override;
+
+private:
+	void SetState(EPlayerLocomotionState NewState);
+
+	// asset player of a state; jump states without a sequence fall back to locomotion
+	FAnimNode_AssetPlayerBase& GetStatePlayer(EPlayerLocomotionState InState);
+
+	// true when the state's sequence is about to end
+	bool IsStateFinishing(EPlayerLocomotionState InState);
+
+	// 1 for UpperBodyBone and its children, 0 for the rest of the skeleton
+	bool BuildUpperBodyWeights();
+
+	bool bUseNativeGraph;
+
+	bool bIsInAir;
+
+	bool bIsAnimationBlended;
+
+	float Speed;
+
+	FName MontageSlotName;
+
+	FName UpperBodyBone;
+
+	float StateBlendTime;
+
+	FAnimNode_BlendSpacePlayer LocomotionPlayer;
+
+	FAnimNode_SequencePlayer JumpStartPlayer;
+
+	FAnimNode_SequencePlayer JumpLoopPlayer;
+
+	FAnimNode_SequencePlayer JumpEndPlayer;
+
+	EPlayerLocomotionState State;
+
+	EPlayerLocomotionState PreviousState;
+
+	// 0 right after a transition, 1 once the new state fully replaced the previous one
+	float StateBlendAlpha;
+
+	bool bNodesInitialized;
+
+	float SlotNodeWeight;
+
+	float SlotSourceWeight;
+
+	float SlotTotalNodeWeight;
+
+	TArray<float> UpperBodyWeights;
+};
 
 UCLASS()
 class THEPUNCH_API UPlayerAnimInstance : public UAnimInstance
@@ -23,6 +119,36 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation")
 	float Speed;
 
+	// evaluates the graph in C++, on by default; the fighter uses this class itself as its anim class,
+	// see AThePunchCharacter::NativeAnimClass, so no Blueprint VM runs at all
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Native Graph")
+	bool bUseNativeGraph;
+
+	// idle/walk/run blend space driven by Speed, the native graph stays off without it
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Native Graph")
+	UBlendSpaceBase* LocomotionBlendSpace;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Native Graph")
+	UAnimSequence* JumpStartSequence;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Native Graph")
+	UAnimSequence* JumpLoopSequence;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Native Graph")
+	UAnimSequence* JumpEndSequence;
+
+	// slot the attack montages play in
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Native Graph")
+	FName MontageSlotName;
+
+	// the montage only drives this bone and its children while IsAnimationBlended
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Native Graph")
+	FName UpperBodyBone;
+
+	// seconds the jump states cross fade
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Native Graph")
+	float StateBlendTime;
+
 public:
 
 	//Constructor
@@ -34,6 +160,11 @@ public:
 	// Native update override point
 	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
 
+protected:
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+	virtual void DestroyAnimInstanceProxy(FAnimInstanceProxy* InProxy) override;
+
 private:
 	APawn* Owner;
-};
\ No newline at end of file
+};
@@ -7,15 +7,19 @@
 
 void UPunchAnimNotify::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 4.5, FColor::Blue, __FUNCTION__);
-
 	if (MeshComp != NULL && MeshComp->GetOwner() != NULL)
 	{
 		AThePunchCharacter* player = Cast<AThePunchCharacter>(MeshComp->GetOwner());
 
-		if (player != NULL && !player->PunchThrowAudioComponent->IsPlaying())
+		if (player != NULL && player->IsLogEnabled(ELogLevel::TRACE))
+		{
+			player->Log(ELogLevel::TRACE, ANSI_TO_TCHAR(__FUNCTION__));
+		}
+
+		// attack scripts play the throw sound themselves
+		if (player != NULL && !player->IsAttackScripted())
 		{
-			player->PunchThrowAudioComponent->Play(0.f);
+			player->PlayThrowSound();
 		}
 	}
 }
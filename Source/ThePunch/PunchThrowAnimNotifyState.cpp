@@ -7,22 +7,31 @@
 
 void UPunchThrowAnimNotifyState::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 4.5, FColor::Orange, TEXT("__FUNCTION__"));
-
 	if (MeshComp != NULL && MeshComp->GetWorld() != NULL)
 	{
 		AThePunchCharacter* player = Cast<AThePunchCharacter>(MeshComp->GetOwner());
 
-		if (player != NULL && !player->PunchThrowAudioComponent->IsPlaying())
+		if (player != NULL && player->IsLogEnabled(ELogLevel::TRACE))
+		{
+			player->Log(ELogLevel::TRACE, ANSI_TO_TCHAR(__FUNCTION__));
+		}
+
+		// attack scripts play the throw sound themselves
+		if (player != NULL && !player->IsAttackScripted())
 		{
-			player->PunchThrowAudioComponent->Play(0.f);
+			player->PlayThrowSound();
 		}
 	}
 }
 
 void UPunchThrowAnimNotifyState::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
 {
-	GEngine->AddOnScreenDebugMessage(-1, 4.5, FColor::Orange, TEXT("__FUNCTION__"));
+	AThePunchCharacter* player = MeshComp != NULL ? Cast<AThePunchCharacter>(MeshComp->GetOwner()) : NULL;
+
+	if (player != NULL && player->IsLogEnabled(ELogLevel::TRACE))
+	{
+		player->Log(ELogLevel::TRACE, ANSI_TO_TCHAR(__FUNCTION__));
+	}
 }
 
 
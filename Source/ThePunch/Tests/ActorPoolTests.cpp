@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ThePunchTestWorld.h"
+#include "ThePunchGameMode.h"
+#include "ActorPool.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FActorPoolKilledFighterTest, "ThePunch.ActorPool.KilledFighterIsParked",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// a fighter that dies goes back to the pool and is the next one handed out
+bool FActorPoolKilledFighterTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+
+	AThePunchGameMode* GameMode = TestWorld.World->GetAuthGameMode<AThePunchGameMode>();
+	AThePunchGameState* GameState = TestWorld.GetGameState();
+
+	if (!TestNotNull(TEXT("Game mode"), GameMode) || !TestNotNull(TEXT("Game state"), GameState))
+	{
+		return false;
+	}
+
+	FActorPool& Pool = GameState->GetActorPool();
+	UClass* FighterClass = TestWorld.GetFighterClass();
+
+	const int32 ParkedBefore = Pool.GetNumParked(FighterClass);
+	AThePunchCharacter* Fighter = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+
+	if (!TestNotNull(TEXT("Fighter"), Fighter))
+	{
+		return false;
+	}
+
+	TestTrue(TEXT("The game mode takes the killed fighter"), GameMode->FighterKilled(Fighter));
+	TestEqual(TEXT("Parked fighters"), Pool.GetNumParked(FighterClass), ParkedBefore + 1);
+	TestTrue(TEXT("Fighter is parked"), Fighter->IsParked());
+	TestFalse(TEXT("Fighter left the match"), GameState->GetFighters().Contains(Fighter));
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ThePunchTestWorld.h"
+#include "AttackScript.h"
+#include "ThePunchHooks.h"
+#include "PunchAnimNotify.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAttackScriptWindowlessAfterScriptedTest, "ThePunch.AttackScripts.WindowlessSectionAfterScripted",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAttackScriptStepsTest, "ThePunch.AttackScripts.StepsFollowMontageTime",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// a section without a window after a scripted one must be left to its notifies, which open the window
+bool FAttackScriptWindowlessAfterScriptedTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+
+	AThePunchCharacter* Fighter = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+
+	if (!TestNotNull(TEXT("Fighter"), Fighter))
+	{
+		return false;
+	}
+
+	const FName SectionName = AThePunchCharacter::GetAttackSectionName(1);
+	UAnimMontage* Scripted = FThePunchTestWorld::MakeAttackMontage(0.1f, 0.3f);
+	UAnimMontage* Windowless = FThePunchTestWorld::MakeAttackMontage(0.f, 0.f);
+
+	FAttackScheduler Scheduler;
+
+	TestTrue(TEXT("A section with a window is scripted"), Scheduler.Start(Fighter, Scripted, SectionName, EAttackType::MELEE_FIST));
+	TestTrue(TEXT("Fighter is scripted"), Fighter->IsAttackScripted());
+
+	TestFalse(TEXT("A section without a window is not scripted"), Scheduler.Start(Fighter, Windowless, SectionName, EAttackType::MELEE_FIST));
+	TestFalse(TEXT("Fighter is no longer scripted"), Fighter->IsAttackScripted());
+
+	// the notify of the windowless section's montage now reaches the fighter
+	UAttackStartNotifyState* Notify = GetMutableDefault<UAttackStartNotifyState>();
+
+	Notify->NotifyBegin(Fighter->GetMesh(), Windowless, 0.2f);
+	TestTrue(TEXT("The notify opens the window"), Fighter->GetIsAttackWindowOpen());
+
+	Notify->NotifyEnd(Fighter->GetMesh(), Windowless);
+	TestFalse(TEXT("The notify closes the window"), Fighter->GetIsAttackWindowOpen());
+
+	// a script whose montage is not playing, as after the montage ended, unscripts the fighter
+	Scheduler.Start(Fighter, Scripted, SectionName, EAttackType::MELEE_FIST);
+	Scheduler.Update();
+
+	TestEqual(TEXT("Running attacks after the montage ended"), Scheduler.GetNumRunning(), 0);
+	TestFalse(TEXT("Fighter is unscripted when its montage ends"), Fighter->IsAttackScripted());
+
+	Fighter->Destroy();
+
+	return true;
+}
+
+// the steps run as the montage reaches their times: the window, the kick's input lock, an early hit and the throw sounds
+bool FAttackScriptStepsTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+
+	AThePunchCharacter* Fighter = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+
+	if (!TestNotNull(TEXT("Fighter"), Fighter))
+	{
+		return false;
+	}
+
+	// window from 0.2 to 0.6, one swing before it and one after
+	UAnimMontage* Montage = FThePunchTestWorld::MakeAttackMontage(0.2f, 0.6f);
+
+	for (const float Time : { 0.1f, 0.7f })
+	{
+		FAnimNotifyEvent Throw;
+		Throw.Notify = NewObject<UPunchAnimNotify>(Montage);
+		Throw.SetTime(Time);
+		Montage->Notifies.Add(Throw);
+	}
+
+	int32 NumThrows = 0;
+	const FDelegateHandle ThrownHandle = FThePunchHooks::OnAttackThrown.AddLambda([Fighter, &NumThrows](AThePunchCharacter* Thrower)
+	{
+		if (Thrower == Fighter)
+		{
+			++NumThrows;
+		}
+	});
+
+	const FName SectionName = AThePunchCharacter::GetAttackSectionName(1);
+	FAttackScheduler Scheduler;
+
+	// a punch runs its window to the end and never touches the keyboard
+	TestTrue(TEXT("The punch is scripted"), Scheduler.Start(Fighter, Montage, SectionName, EAttackType::MELEE_FIST));
+
+	Scheduler.Resume(Fighter, 0.f);
+	TestFalse(TEXT("Window before WindowStart"), Fighter->GetIsAttackWindowOpen());
+	TestEqual(TEXT("Throw sounds before the first one is due"), NumThrows, 0);
+
+	Scheduler.Resume(Fighter, 0.15f);
+	TestEqual(TEXT("Throw sounds once the first one is due"), NumThrows, 1);
+	TestFalse(TEXT("Window between the first swing and WindowStart"), Fighter->GetIsAttackWindowOpen());
+
+	Scheduler.Resume(Fighter, 0.2f);
+	TestTrue(TEXT("Window at WindowStart"), Fighter->GetIsAttackWindowOpen());
+	TestTrue(TEXT("A punch leaves the keyboard enabled"), Fighter->GetIsKeyboardEnabled());
+
+	Scheduler.Resume(Fighter, 0.4f);
+	TestTrue(TEXT("Window inside the window"), Fighter->GetIsAttackWindowOpen());
+
+	Scheduler.Resume(Fighter, 0.6f);
+	TestFalse(TEXT("Window at WindowEnd"), Fighter->GetIsAttackWindowOpen());
+	TestEqual(TEXT("Throw sounds at WindowEnd"), NumThrows, 1);
+
+	Scheduler.Resume(Fighter, 0.8f);
+	TestEqual(TEXT("Throw sounds after the second one is due"), NumThrows, 2);
+
+	// a kick locks the keyboard with its window, and a hit closes both before WindowEnd
+	NumThrows = 0;
+	TestTrue(TEXT("The kick is scripted"), Scheduler.Start(Fighter, Montage, SectionName, EAttackType::MELEE_KICK));
+
+	Scheduler.Resume(Fighter, 0.25f);
+	TestTrue(TEXT("Kick window past WindowStart"), Fighter->GetIsAttackWindowOpen());
+	TestFalse(TEXT("A kick locks the keyboard"), Fighter->GetIsKeyboardEnabled());
+	TestEqual(TEXT("Throw sounds a late first resume catches up on"), NumThrows, 1);
+
+	Scheduler.Resume(Fighter, 0.3f);
+	TestTrue(TEXT("Kick window without a hit"), Fighter->GetIsAttackWindowOpen());
+
+	Scheduler.NotifyHit(Fighter);
+	Scheduler.Resume(Fighter, 0.35f);
+	TestFalse(TEXT("A hit closes the window before WindowEnd"), Fighter->GetIsAttackWindowOpen());
+	TestTrue(TEXT("Closing the window unlocks the keyboard"), Fighter->GetIsKeyboardEnabled());
+
+	FThePunchHooks::OnAttackThrown.Remove(ThrownHandle);
+
+	Scheduler.Stop(Fighter);
+	Fighter->Destroy();
+
+	return true;
+}
+
+#endif
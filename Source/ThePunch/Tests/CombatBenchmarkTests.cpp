@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#include "ThePunchTestWorld.h"
+#include "CombatBenchmarks.h"
+#include "Components/CapsuleComponent.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatBenchmarkBaselineTest, "ThePunch.Benchmarks.Baseline",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FServerHitReactionCostTest, "ThePunch.Benchmarks.ServerHitReactions",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// every benchmark must be in Config/CombatBenchmarkBaseline.json and within its threshold
+bool FCombatBenchmarkBaselineTest::RunTest(const FString& Parameters)
+{
+	// the gate starts once numbers were recorded on a machine with the engine, until then it only reports
+	if (!FCombatBenchmarks::HasBaseline())
+	{
+		AddWarning(TEXT("No combat benchmark baseline recorded yet, record one with ThePunch.Bench update and commit it"));
+		return true;
+	}
+
+	FThePunchTestWorld TestWorld;
+
+	TArray<FCombatBenchmarkResult> Results;
+
+	if (!FCombatBenchmarks::RunBenchmarks(TestWorld.World, Results))
+	{
+		AddError(TEXT("The benchmark fighters could not be spawned"));
+		return false;
+	}
+
+	TArray<FString> Failures;
+	FCombatBenchmarks::CompareWithBaseline(Results, false, Failures);
+
+	for (const FString& Failure : Failures)
+	{
+		AddError(Failure);
+	}
+
+	return Failures.Num() == 0;
+}
+
+/**
+* MeasureServerHitReactions - whole frames of a world with 50 fighters being hit, the physics step included
+* @param bSimulate bSimulateSkeletalMeshOnDedicatedServer for the run, the fighters are spawned with it
+* @param OutMaxSimulating most fighters simulating a reaction in any frame
+*/
+static FCombatBenchmarkResult MeasureServerHitReactions(bool bSimulate, int32& OutMaxSimulating)
+{
+	static const int32 NumVictims = 50;
+
+	// mesh bodies are created with the setting, change it before the world exists
+	UPhysicsSettings* PhysicsSettings = UPhysicsSettings::Get();
+	const bool bWasSimulating = PhysicsSettings->bSimulateSkeletalMeshOnDedicatedServer;
+	PhysicsSettings->bSimulateSkeletalMeshOnDedicatedServer = bSimulate;
+
+	FCombatBenchmarkResult Result;
+	OutMaxSimulating = 0;
+
+	{
+		FThePunchTestWorld TestWorld;
+
+		UWorld* World = TestWorld.World;
+		AThePunchGameState* GameState = TestWorld.GetGameState();
+		AThePunchCharacter* Attacker = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+
+		TArray<AThePunchCharacter*> Victims;
+
+		for (int32 Index = 0; Index < NumVictims; ++Index)
+		{
+			AThePunchCharacter* Victim = TestWorld.SpawnFighter(FVector(300.f + (Index % 10) * 200.f, (Index / 10) * 200.f, 200.f));
+
+			if (Victim)
+			{
+				Victims.Add(Victim);
+			}
+		}
+
+		// every victim may simulate, the setting is what is measured and not the slot budget
+		if (GameState)
+		{
+			GameState->GetHitReactions().SetMaxSimulatedFighters(NumVictims);
+		}
+
+		int32 Frame = 0;
+
+		Result = FCombatBenchmarks::Measure(bSimulate ? TEXT("HitReactions.Server50.Simulated") : TEXT("HitReactions.Server50.Canned"), 120,
+			[World, GameState, Attacker, &Victims, &Frame, &OutMaxSimulating]()
+		{
+			// each victim is hit again every second of game time
+			if (Frame++ % 30 == 0)
+			{
+				for (AThePunchCharacter* Victim : Victims)
+				{
+					const FHitResult Hit(Victim, Victim->GetCapsuleComponent(), Victim->GetActorLocation(), -FVector::ForwardVector);
+					Victim->ReceiveAttackHit(Attacker, FVector::ZeroVector, Hit);
+				}
+			}
+
+			World->Tick(LEVELTICK_All, 1.f / 30.f);
+
+			if (GameState)
+			{
+				OutMaxSimulating = FMath::Max(OutMaxSimulating, GameState->GetHitReactions().GetNumActive());
+			}
+		});
+	}
+
+	PhysicsSettings->bSimulateSkeletalMeshOnDedicatedServer = bWasSimulating;
+
+	return Result;
+}
+
+// frame cost of 50 fighters reacting to hits with skeletal mesh simulation on the dedicated server on and off
+bool FServerHitReactionCostTest::RunTest(const FString& Parameters)
+{
+	if (!IsRunningDedicatedServer())
+	{
+		AddWarning(TEXT("bSimulateSkeletalMeshOnDedicatedServer only applies to a dedicated server, run this on the ThePunchServer target"));
+	}
+
+	int32 SimulatingOn = 0;
+	int32 SimulatingOff = 0;
+
+	const FCombatBenchmarkResult On = MeasureServerHitReactions(true, SimulatingOn);
+	const FCombatBenchmarkResult Off = MeasureServerHitReactions(false, SimulatingOff);
+
+	AddInfo(FString::Printf(TEXT("50 fighters hit every second: %.3f ms per frame with simulation on (up to %d simulating), %.3f ms with it off (up to %d simulating), %.1f against %.1f allocations per frame"),
+		On.NsPerOp / 1e6, SimulatingOn, Off.NsPerOp / 1e6, SimulatingOff, On.AllocsPerOp, Off.AllocsPerOp));
+
+	if (IsRunningDedicatedServer())
+	{
+		TestEqual(TEXT("Fighters simulating on a dedicated server with the setting off"), SimulatingOff, 0);
+	}
+
+	return true;
+}
+
+#endif
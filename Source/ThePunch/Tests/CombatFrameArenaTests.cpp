@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+#include "ThePunchTestWorld.h"
+#include "ThePunch.h"
+#include "CombatBenchmarks.h"
+#include "CombatFrameArena.h"
+#include "Animation/AnimInstance.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatFrameArenaZeroAllocationTest, "ThePunch.FrameArena.ZeroAllocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatFrameArenaAttackCycleTest, "ThePunch.FrameArena.AttackCycleAllocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// once the arena and the name tables are warm, the attack path must not touch the heap
+bool FCombatFrameArenaZeroAllocationTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+
+	AThePunchCharacter* Fighter = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+
+	if (!TestNotNull(TEXT("Fighter"), Fighter))
+	{
+		return false;
+	}
+
+	TArray<FCombatBenchmarkResult> Results;
+
+	Results.Add(FCombatBenchmarks::Measure(TEXT("FrameArena.Containers"), 1000, [Fighter]()
+	{
+		TArray<AThePunchCharacter*, FCombatFrameAllocator> Fighters;
+
+		for (int32 Index = 0; Index < 64; ++Index)
+		{
+			Fighters.Add(Fighter);
+		}
+
+		FCombatFrameString Message;
+		Message.Append(TEXT("hit ")).Append(Fighter->GetFName()).Append(TEXT(" for ")).Append(42).Append(TEXT(" at ")).Append(1.5f);
+	}));
+
+	Results.Add(FCombatBenchmarks::Measure(TEXT("AttackInput.SectionSelection"), 1000, [Fighter]()
+	{
+		const FPlayerAttackMontage* AttackMontage = Fighter->FindAttackMontage(EAttackType::MELEE_FIST);
+		const int32 SectionCount = AttackMontage ? FMath::Max(AttackMontage->AnimSectionCount, 1) : 3;
+
+		AThePunchCharacter::GetAttackSectionName(rand() % SectionCount + 1);
+	}));
+
+	Results.Add(FCombatBenchmarks::Measure(TEXT("FireLineTrace.Prepare"), 1000, [Fighter]()
+	{
+		FVector Start;
+		FVector End;
+		FCollisionQueryParams TraceParams;
+
+		Fighter->PrepareLineTrace(Start, End, TraceParams);
+	}));
+
+	// the output log with LogThePunch suppressed, as in a server build
+	const ELogVerbosity::Type Verbosity = LogThePunch.GetVerbosity();
+	LogThePunch.SetVerbosity(ELogVerbosity::NoLogging);
+
+	Results.Add(FCombatBenchmarks::Measure(TEXT("Log.Suppressed"), 1000, [Fighter]()
+	{
+		Fighter->Log(ELogLevel::INFO, TEXT("ThePunch.FrameArena.ZeroAllocations"), ELogOutput::OUTPUT_LOG);
+	}));
+
+	LogThePunch.SetVerbosity(Verbosity);
+
+	for (const FCombatBenchmarkResult& Result : Results)
+	{
+		TestEqual(FString::Printf(TEXT("%s allocations per call"), *Result.Name), Result.AllocsPerOp, 0.0);
+	}
+
+	Fighter->Destroy();
+
+	return true;
+}
+
+// a whole attack on the game's fighter, input to hit to end, allocates no more than the engine playing its montage
+bool FCombatFrameArenaAttackCycleTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+
+	AThePunchCharacter* Attacker = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+	AThePunchCharacter* Victim = TestWorld.SpawnFighter(FVector(100.f, 0.f, 200.f));
+
+	if (!TestNotNull(TEXT("Attacker"), Attacker) || !TestNotNull(TEXT("Victim"), Victim))
+	{
+		return false;
+	}
+
+	const FPlayerAttackMontage* AttackMontage = Attacker->FindAttackMontage(EAttackType::MELEE_FIST);
+	UAnimInstance* AnimInstance = Attacker->GetMesh()->GetAnimInstance();
+
+	if (!TestTrue(TEXT("The default pawn has a punch montage"), AttackMontage && AttackMontage->Montage) || !TestNotNull(TEXT("Anim instance"), AnimInstance))
+	{
+		return false;
+	}
+
+	UAnimMontage* Montage = AttackMontage->Montage;
+	USkeletalMeshComponent* Mesh = Attacker->GetMesh();
+
+	// the output log with LogThePunch suppressed, as in a server build
+	const ELogOutput LogOutput = Attacker->DefaultLogOutput;
+	const ELogVerbosity::Type Verbosity = LogThePunch.GetVerbosity();
+	Attacker->DefaultLogOutput = ELogOutput::OUTPUT_LOG;
+	LogThePunch.SetVerbosity(ELogVerbosity::NoLogging);
+
+	// what the engine allocates to play, stop and retire a montage instance on this mesh
+	const FCombatBenchmarkResult Engine = FCombatBenchmarks::Measure(TEXT("Engine.MontagePlay"), 200, [AnimInstance, Mesh, Montage]()
+	{
+		AnimInstance->Montage_Play(Montage, 1.f);
+		AnimInstance->Montage_JumpToSection(AThePunchCharacter::GetAttackSectionName(1), Montage);
+		AnimInstance->Montage_Stop(0.f, Montage);
+		Mesh->TickAnimation(1.f / 60.f, false);
+	});
+
+	// the same montage through a whole attack: target selection, hitbox attachment, scripting, the hit and its effects
+	const FCombatBenchmarkResult Attack = FCombatBenchmarks::Measure(TEXT("Attack.FullCycle"), 200, [Attacker, Victim, AnimInstance, Mesh, Montage]()
+	{
+		Attacker->AttackInput(EAttackType::MELEE_FIST);
+		Attacker->AttackStart();
+
+		FHitResult Hit(Victim, Victim->GetCapsuleComponent(), Victim->GetActorLocation(), FVector::ForwardVector);
+		Attacker->OnAttackHit(NULL, Victim, Victim->GetCapsuleComponent(), FVector::ZeroVector, Hit);
+
+		Attacker->AttackEnd();
+
+		AnimInstance->Montage_Stop(0.f, Montage);
+		Mesh->TickAnimation(1.f / 60.f, false);
+	});
+
+	LogThePunch.SetVerbosity(Verbosity);
+	Attacker->DefaultLogOutput = LogOutput;
+
+	AddInfo(FString::Printf(TEXT("Allocations per attack %.2f, of which the engine's montage %.2f"), Attack.AllocsPerOp, Engine.AllocsPerOp));
+
+	TestEqual(TEXT("Allocations per attack on top of the engine's montage"), FMath::Max(Attack.AllocsPerOp - Engine.AllocsPerOp, 0.0), 0.0);
+
+	Attacker->Destroy();
+	Victim->Destroy();
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ThePunchTestWorld.h"
+#include "HitReactionPool.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHitReactionPoolMergeTest, "ThePunch.HitReactions.LightHitKeepsKnockdown",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// a light hit landing during a knockdown must neither shorten it nor turn it into a light reaction
+bool FHitReactionPoolMergeTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+
+	AThePunchCharacter* Fighter = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+
+	if (!TestNotNull(TEXT("Fighter"), Fighter))
+	{
+		return false;
+	}
+
+	FHitReactionPool Pool;
+	Pool.SetMaxSimulatedFighters(1);
+
+	TestTrue(TEXT("Knockdown gets the slot"), Pool.Request(Fighter, EHitReaction::KNOCKDOWN, 1.f, 2.f, 0.f));
+	TestTrue(TEXT("The light hit keeps the slot"), Pool.Request(Fighter, EHitReaction::LIGHT, 0.5f, 0.4f, 0.5f));
+
+	// past the end of the light hit, before the end of the knockdown
+	Pool.Update(1.5f);
+	TestEqual(TEXT("Still knocked down"), Pool.GetNumActive(), 1);
+
+	// a later hit pushes the end out
+	TestTrue(TEXT("Another light hit"), Pool.Request(Fighter, EHitReaction::LIGHT, 0.5f, 0.4f, 1.9f));
+
+	Pool.Update(2.1f);
+	TestEqual(TEXT("The later end time wins"), Pool.GetNumActive(), 1);
+
+	Pool.Update(2.4f);
+	TestEqual(TEXT("Ended"), Pool.GetNumActive(), 0);
+
+	Fighter->Destroy();
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ThePunchTestWorld.h"
+#include "MatchStateExport.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatchStateTruncationTest, "ThePunch.MatchState.TruncationIsFlagged",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMatchStateReaderProcessTest, "ThePunch.MatchState.ReaderProcess",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// one fighter more than a slot holds, so every snapshot is truncated
+static void SpawnMatchStateFighters(FThePunchTestWorld& TestWorld, TArray<AThePunchCharacter*>& OutFighters)
+{
+	for (int32 Index = 0; Index <= MatchState::MaxFighters; ++Index)
+	{
+		AThePunchCharacter* Fighter = TestWorld.SpawnFighter(FVector(Index * 200.f, 0.f, 200.f));
+
+		if (Fighter)
+		{
+			OutFighters.Add(Fighter);
+		}
+	}
+}
+
+// a match larger than a slot exports the first fighters and tells observers how many there are
+bool FMatchStateTruncationTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+
+	TArray<AThePunchCharacter*> Fighters;
+	SpawnMatchStateFighters(TestWorld, Fighters);
+
+	TestEqual(TEXT("Fighters"), Fighters.Num(), MatchState::MaxFighters + 1);
+
+	const FString Name = FString::Printf(TEXT("ThePunchMatchStateTest%u"), FPlatformProcess::GetCurrentProcessId());
+
+	FMatchStateExport Export;
+
+	if (!TestTrue(TEXT("The region is created"), Export.Open(Name)))
+	{
+		return false;
+	}
+
+	Export.Publish(Fighters, 1.0);
+
+	FMatchStateReader Reader;
+	TestTrue(TEXT("The region is mapped"), Reader.Open(Name));
+
+	FMatchStateSlot* Slot = new FMatchStateSlot;
+	int32 Retries = 0;
+
+	if (TestTrue(TEXT("The snapshot is read"), Reader.ReadLatest(*Slot, Retries)))
+	{
+		TestTrue(TEXT("The snapshot is consistent"), FMatchStateReader::IsConsistent(*Slot));
+		TestEqual(TEXT("Exported fighters"), (int32)Slot->NumFighters, (int32)MatchState::MaxFighters);
+		TestEqual(TEXT("Fighters in the match"), (int32)Slot->NumFightersInMatch, Fighters.Num());
+	}
+
+	delete Slot;
+
+	Reader.Close();
+	Export.Close();
+
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		Fighter->Destroy();
+	}
+
+	return true;
+}
+
+// a second process maps the region and checks every snapshot while this one keeps publishing
+bool FMatchStateReaderProcessTest::RunTest(const FString& Parameters)
+{
+	if (!GIsEditor)
+	{
+		AddWarning(TEXT("The reader process is a commandlet, run the test from the editor executable"));
+		return true;
+	}
+
+	FThePunchTestWorld TestWorld;
+
+	TArray<AThePunchCharacter*> Fighters;
+	SpawnMatchStateFighters(TestWorld, Fighters);
+
+	if (!TestTrue(TEXT("Fighters are spawned"), Fighters.Num() > 0))
+	{
+		return false;
+	}
+
+	const FString Name = FString::Printf(TEXT("ThePunchMatchStateProcessTest%u"), FPlatformProcess::GetCurrentProcessId());
+
+	FMatchStateExport Export;
+
+	if (!TestTrue(TEXT("The region is created"), Export.Open(Name)))
+	{
+		return false;
+	}
+
+	const FString ProjectPath = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	const FString Arguments = FString::Printf(TEXT("\"%s\" -run=ThePunchMatchState -Region=%s -Seconds=3 -unattended -nullrhi -nosplash -nopause"), *ProjectPath, *Name);
+
+	FProcHandle Reader = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Arguments, true, true, true, NULL, 0, NULL, NULL);
+
+	if (!TestTrue(TEXT("The reader process starts"), Reader.IsValid()))
+	{
+		return false;
+	}
+
+	// the reader needs a few seconds to start, publish at a frame rate well above a game's until it is done
+	const double EndTime = FPlatformTime::Seconds() + 300.0;
+	double WorldTime = 0.0;
+
+	while (FPlatformProcess::IsProcRunning(Reader) && FPlatformTime::Seconds() < EndTime)
+	{
+		WorldTime += 1.0 / 240.0;
+
+		Export.RecordHit(Fighters[0], Fighters.Last(), FVector::ZeroVector, (float)WorldTime);
+		Export.Publish(Fighters, WorldTime);
+
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	int32 ReturnCode = -1;
+
+	if (FPlatformProcess::IsProcRunning(Reader))
+	{
+		AddError(TEXT("The reader process did not finish"));
+		FPlatformProcess::TerminateProc(Reader);
+	}
+	else
+	{
+		FPlatformProcess::GetProcReturnCode(Reader, &ReturnCode);
+		TestEqual(TEXT("Reader process exit code, 0 when every snapshot was consistent"), ReturnCode, 0);
+	}
+
+	FPlatformProcess::CloseProc(Reader);
+
+	Export.Close();
+
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		Fighter->Destroy();
+	}
+
+	return ReturnCode == 0;
+}
+
+#endif
@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ThePunchTestWorld.h"
+#include "ThePunchArena.h"
+#include "FighterNetInterest.h"
+#include "GameFramework/PlayerController.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNetInterestMultipleViewersTest, "ThePunch.NetInterest.MultipleViewers",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FNetInterestPossessedDormancyTest, "ThePunch.NetInterest.PossessedFighterStaysAwake",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// three viewers, as three client connections would have: two fighters of different arenas and a spectator
+bool FNetInterestMultipleViewersTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+	UWorld* World = TestWorld.World;
+	AThePunchGameState* GameState = TestWorld.GetGameState();
+
+	if (!TestNotNull(TEXT("Game state"), GameState))
+	{
+		return false;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AThePunchArena* ArenaA = World->SpawnActor<AThePunchArena>(AThePunchArena::StaticClass(), FVector(0.f, 0.f, 0.f), FRotator::ZeroRotator, SpawnParams);
+	// the arenas are well within the interest radius of each other, only arena isolation keeps them apart
+	AThePunchArena* ArenaB = World->SpawnActor<AThePunchArena>(AThePunchArena::StaticClass(), FVector(2000.f, 0.f, 0.f), FRotator::ZeroRotator, SpawnParams);
+
+	AThePunchCharacter* FighterA1 = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+	AThePunchCharacter* FighterA2 = TestWorld.SpawnFighter(FVector(300.f, 0.f, 200.f));
+	AThePunchCharacter* FighterB1 = TestWorld.SpawnFighter(FVector(2000.f, 0.f, 200.f));
+	AThePunchCharacter* FighterB2 = TestWorld.SpawnFighter(FVector(2300.f, 0.f, 200.f));
+
+	// a fighter outside any arena and outside the radius of every viewer
+	AThePunchCharacter* Loner = TestWorld.SpawnFighter(FVector(20000.f, 0.f, 200.f));
+
+	if (!TestNotNull(TEXT("Arena A"), ArenaA) || !TestNotNull(TEXT("Arena B"), ArenaB) || !TestNotNull(TEXT("Fighter A1"), FighterA1)
+		|| !TestNotNull(TEXT("Fighter A2"), FighterA2) || !TestNotNull(TEXT("Fighter B1"), FighterB1) || !TestNotNull(TEXT("Fighter B2"), FighterB2)
+		|| !TestNotNull(TEXT("Loner"), Loner))
+	{
+		return false;
+	}
+
+	ArenaA->AddFighter(FighterA1);
+	ArenaA->AddFighter(FighterA2);
+	ArenaB->AddFighter(FighterB1);
+	ArenaB->AddFighter(FighterB2);
+
+	// a spectator camera standing next to arena B
+	AActor* SpectatorCamera = World->SpawnActor<AActor>(AActor::StaticClass(), FVector(2100.f, 0.f, 200.f), FRotator::ZeroRotator, SpawnParams);
+
+	APlayerController* ViewerA = World->SpawnActor<APlayerController>(APlayerController::StaticClass(), SpawnParams);
+	APlayerController* ViewerB = World->SpawnActor<APlayerController>(APlayerController::StaticClass(), SpawnParams);
+	APlayerController* Spectator = World->SpawnActor<APlayerController>(APlayerController::StaticClass(), SpawnParams);
+
+	if (!TestNotNull(TEXT("Viewer A"), ViewerA) || !TestNotNull(TEXT("Viewer B"), ViewerB) || !TestNotNull(TEXT("Spectator"), Spectator))
+	{
+		return false;
+	}
+
+	ViewerA->SetViewTarget(FighterA1);
+	ViewerB->SetViewTarget(FighterB1);
+	Spectator->SetViewTarget(SpectatorCamera);
+
+	// what AThePunchGameState::Tick does in host mode before relevancy
+	ArenaA->UpdateCombat(0.f);
+	ArenaB->UpdateCombat(0.f);
+	GameState->RebuildFighterGrid();
+
+	FFighterNetInterest NetInterest;
+	NetInterest.InterestRadius = 5000.f;
+	NetInterest.Update(World, GameState->GetFighters(), GameState->GetFighterGrid());
+
+	struct FExpectation
+	{
+		const TCHAR* Description;
+		const AActor* ViewTarget;
+		const AThePunchCharacter* Fighter;
+		bool bRelevant;
+	};
+
+	const FExpectation Expectations[] =
+	{
+		{ TEXT("A1 sees its opponent"), FighterA1, FighterA2, true },
+		{ TEXT("A1 does not see arena B"), FighterA1, FighterB2, false },
+		{ TEXT("B1 sees its opponent"), FighterB1, FighterB2, true },
+		{ TEXT("B1 does not see arena A"), FighterB1, FighterA2, false },
+		{ TEXT("The spectator sees arena B"), SpectatorCamera, FighterB1, true },
+		{ TEXT("The spectator sees arena A"), SpectatorCamera, FighterA1, true },
+		{ TEXT("The spectator does not see far fighters"), SpectatorCamera, Loner, false },
+	};
+
+	for (const FExpectation& Expectation : Expectations)
+	{
+		bool bRelevant = false;
+
+		if (TestTrue(FString::Printf(TEXT("%s: the viewer has a list"), Expectation.Description), NetInterest.FindRelevance(Expectation.ViewTarget, Expectation.Fighter, bRelevant)))
+		{
+			TestEqual(Expectation.Description, bRelevant, Expectation.bRelevant);
+		}
+	}
+
+	return true;
+}
+
+// a player standing still must keep its channel, its inputs are what would wake it up
+bool FNetInterestPossessedDormancyTest::RunTest(const FString& Parameters)
+{
+	FThePunchTestWorld TestWorld;
+	UWorld* World = TestWorld.World;
+
+	AThePunchCharacter* Fighter = TestWorld.SpawnFighter(FVector(0.f, 0.f, 200.f));
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	APlayerController* Player = World->SpawnActor<APlayerController>(APlayerController::StaticClass(), SpawnParams);
+
+	if (!TestNotNull(TEXT("Fighter"), Fighter) || !TestNotNull(TEXT("Player"), Player))
+	{
+		return false;
+	}
+
+	TestTrue(TEXT("An idle fighter without a player may go dormant"), Fighter->CanGoDormant());
+
+	Player->Possess(Fighter);
+
+	TestFalse(TEXT("A possessed fighter never goes dormant"), Fighter->CanGoDormant());
+
+	Player->UnPossess();
+
+	TestTrue(TEXT("A released fighter may go dormant again"), Fighter->CanGoDormant());
+
+	Fighter->Destroy();
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ThePunchCharacter.h"
+#include "ThePunchGameState.h"
+#include "AttackStartNotifyState.h"
+#include "Animation/AnimMontage.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+
+/**
+ * A game world with the project's game mode for the automation tests, torn down with the object.
+ * Run the tests with:
+ *   UE4Editor-Cmd ThePunch.uproject -ExecCmds="Automation RunTests ThePunch; Quit" -unattended -nullrhi
+ */
+class FThePunchTestWorld
+{
+public:
+	FThePunchTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		const FURL URL;
+		World->SetGameMode(URL);
+		World->InitializeActorsForPlay(URL);
+		World->BeginPlay();
+	}
+
+	~FThePunchTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	AThePunchGameState* GetGameState() const
+	{
+		return World->GetGameState<AThePunchGameState>();
+	}
+
+	// the default pawn class of the game mode, the blueprint fighter when it is set
+	UClass* GetFighterClass() const
+	{
+		const AGameModeBase* GameMode = World->GetAuthGameMode();
+
+		return GameMode && GameMode->DefaultPawnClass ? *GameMode->DefaultPawnClass : AThePunchCharacter::StaticClass();
+	}
+
+	AThePunchCharacter* SpawnFighter(const FVector& Location, UClass* FighterClass = NULL)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		return World->SpawnActor<AThePunchCharacter>(FighterClass ? FighterClass : GetFighterClass(), Location, FRotator::ZeroRotator, SpawnParams);
+	}
+
+	/**
+	* MakeAttackMontage - a one second montage with a start_1 section, for tests that need no animation
+	* @param WindowStart time the UAttackStartNotifyState begins
+	* @param WindowEnd time it ends; no notify is added when WindowEnd is not after WindowStart
+	*/
+	static UAnimMontage* MakeAttackMontage(float WindowStart, float WindowEnd)
+	{
+		UAnimMontage* Montage = NewObject<UAnimMontage>(GetTransientPackage());
+		Montage->SequenceLength = 1.f;
+
+		FCompositeSection Section;
+		Section.SectionName = AThePunchCharacter::GetAttackSectionName(1);
+		Section.SetTime(0.f);
+		Montage->CompositeSections.Add(Section);
+
+		if (WindowEnd > WindowStart)
+		{
+			FAnimNotifyEvent Window;
+			Window.NotifyStateClass = NewObject<UAttackStartNotifyState>(Montage);
+			Window.SetTime(WindowStart);
+			Window.SetDuration(WindowEnd - WindowStart);
+			Montage->Notifies.Add(Window);
+		}
+
+		return Montage;
+	}
+
+	UWorld* World;
+};
+
+#endif
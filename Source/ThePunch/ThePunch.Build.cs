@@ -8,6 +8,13 @@ public class ThePunch : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+		// the combat runtime only; VR, touch, audio and debug drawing live in the optional modules
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
+
+		// the optional modules include the combat headers and FThePunchHooks
+		PublicIncludePaths.Add(ModuleDirectory);
+
+		// combat benchmark baseline, native anim graph nodes
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json", "AnimGraphRuntime" });
 	}
 }
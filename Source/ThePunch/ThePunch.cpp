@@ -1,7 +1,30 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "ThePunch.h"
+#include "ThePunchHooks.h"
+#include "CombatLatency.h"
+#include "HAL/PlatformTime.h"
+#include "CoreGlobals.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, ThePunch, "ThePunch" );
- 
\ No newline at end of file
+/** the combat runtime, loads the optional feature modules once it is up */
+class FThePunchModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FDefaultGameModuleImpl::StartupModule();
+
+		// combat paths record from any thread, bind the histograms to the end of frame before the first one does
+		FCombatLatency::Get();
+
+		// the core entry covers the whole process up to here, engine startup and module loading included
+		FThePunchHooks::RecordModuleStartup(TEXT("ThePunch"), FPlatformTime::Seconds() - GStartTime, 0);
+		FThePunchHooks::LoadOptionalModules();
+		FThePunchHooks::LogModules();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FThePunchModule, ThePunch, "ThePunch" );
+
+DEFINE_LOG_CATEGORY(LogThePunch);
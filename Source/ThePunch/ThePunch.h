@@ -3,3 +3,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+// combat timings, view with "stat ThePunch"
+DECLARE_STATS_GROUP(TEXT("ThePunch"), STATGROUP_ThePunch, STATCAT_Advanced);
+
+// gameplay log category, silence with "log LogThePunch off"
+DECLARE_LOG_CATEGORY_EXTERN(LogThePunch, Log, All);
@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchArena.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchGameState.h"
+#include "Engine/World.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+
+AThePunchArena::AThePunchArena()
+{
+	// arenas are updated by the game state, not by their own tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("ArenaRoot"));
+
+	MaxFighters = 2;
+	SpawnRadius = 300.f;
+	CombatBudgetMs = 1.f;
+	BudgetFrames = 30;
+	ThrottledTickInterval = 1.f / 15.f;
+
+	FrameCycles = 0;
+	BudgetStreak = 0;
+	bThrottled = false;
+}
+
+void AThePunchArena::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	if (GameState)
+	{
+		GameState->RegisterArena(this);
+	}
+}
+
+void AThePunchArena::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	if (GameState)
+	{
+		GameState->UnregisterArena(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AThePunchArena::AddFighter(AThePunchCharacter* Fighter)
+{
+	if (Fighter != NULL)
+	{
+		Fighters.AddUnique(Fighter);
+		Fighter->SetArena(this);
+	}
+}
+
+void AThePunchArena::RemoveFighter(AThePunchCharacter* Fighter)
+{
+	Fighters.RemoveSingleSwap(Fighter);
+}
+
+FTransform AThePunchArena::GetSpawnTransform() const
+{
+	// fighters face each other across the arena center
+	const float Angle = 2.f * PI * Fighters.Num() / FMath::Max(MaxFighters, 1);
+	const FVector Offset(FMath::Cos(Angle) * SpawnRadius, FMath::Sin(Angle) * SpawnRadius, 0.f);
+
+	return FTransform((-Offset).Rotation(), GetActorLocation() + Offset);
+}
+
+bool AThePunchArena::HasFreeSlot() const
+{
+	// a throttled arena would only get slower with another fighter
+	return Fighters.Num() < MaxFighters && !bThrottled;
+}
+
+void AThePunchArena::ApplyBudget()
+{
+	for (AThePunchCharacter* Fighter : Fighters)
+	{
+		// a fighter in combat keeps its full rate, its attack windows and hits depend on it
+		const float TickInterval = bThrottled && !Fighter->IsInCombat() ? ThrottledTickInterval : 0.f;
+
+		if (Fighter->GetActorTickInterval() != TickInterval)
+		{
+			Fighter->SetActorTickInterval(TickInterval);
+			Fighter->GetMesh()->SetComponentTickInterval(TickInterval);
+		}
+	}
+}
+
+void AThePunchArena::UpdateCombat(float DeltaSeconds)
+{
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	FighterGrid.Rebuild(Fighters);
+
+	const float FighterMs = FPlatformTime::ToMilliseconds(FrameCycles);
+	const float UpdateMs = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles);
+	const float CombatMs = FighterMs + UpdateMs;
+
+	FrameCycles = 0;
+
+	// running averages over the frames since the last reset
+	++Metrics.Frames;
+	Metrics.AverageCombatMs += (CombatMs - Metrics.AverageCombatMs) / Metrics.Frames;
+	Metrics.AverageFighterMs += (FighterMs - Metrics.AverageFighterMs) / Metrics.Frames;
+	Metrics.AverageUpdateMs += (UpdateMs - Metrics.AverageUpdateMs) / Metrics.Frames;
+	Metrics.PeakCombatMs = FMath::Max(Metrics.PeakCombatMs, CombatMs);
+
+	const bool bOverBudget = CombatMs > CombatBudgetMs;
+
+	if (bOverBudget)
+	{
+		++Metrics.FramesOverBudget;
+	}
+
+	// one slow frame is not enough to throttle, nor one fast frame to stop
+	BudgetStreak = bOverBudget != bThrottled ? BudgetStreak + 1 : 0;
+
+	if (BudgetStreak >= BudgetFrames)
+	{
+		bThrottled = !bThrottled;
+		BudgetStreak = 0;
+	}
+
+	if (bThrottled)
+	{
+		++Metrics.FramesThrottled;
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FString GetArenaBaselinePath()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Metrics") / TEXT("ArenaBaseline.json");
+}
+
+/**
+ * Prints the metrics of every hosted arena, matches per core and memory per match.
+ * "baseline" on a host with a single arena records it as the one-match-per-process baseline;
+ * every other run prints the host next to that baseline.
+ */
+static void DumpArenaMetrics(const TArray<FString>& Args, UWorld* World)
+{
+	AThePunchGameState* GameState = World ? World->GetGameState<AThePunchGameState>() : NULL;
+
+	if (GameState == NULL || GameState->GetArenas().Num() == 0)
+	{
+		UE_LOG(LogThePunch, Display, TEXT("No arenas hosted, start the map with ?Arenas=N"));
+		return;
+	}
+
+	float TotalFighterMs = 0.f;
+	float TotalUpdateMs = 0.f;
+	int32 NumThrottled = 0;
+
+	for (const AThePunchArena* Arena : GameState->GetArenas())
+	{
+		const FArenaMetrics& Metrics = Arena->GetMetrics();
+
+		UE_LOG(LogThePunch, Display, TEXT("%-24s fighters %2d  avg %6.3f ms (fighters %6.3f, update %6.3f)  peak %6.3f ms  over budget %5d/%-6d  throttled %5d%s  attacks %5d  hits %5d"),
+			*Arena->GetName(), Arena->GetFighters().Num(), Metrics.AverageCombatMs, Metrics.AverageFighterMs, Metrics.AverageUpdateMs,
+			Metrics.PeakCombatMs, Metrics.FramesOverBudget, Metrics.Frames, Metrics.FramesThrottled, Arena->IsThrottled() ? TEXT(" now") : TEXT(""),
+			Metrics.Attacks, Metrics.Hits);
+
+		TotalFighterMs += Metrics.AverageFighterMs;
+		TotalUpdateMs += Metrics.AverageUpdateMs;
+		NumThrottled += Arena->IsThrottled() ? 1 : 0;
+	}
+
+	const int32 NumArenas = GameState->GetArenas().Num();
+	const double ResidentMB = FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+	const float BusyMs = GameState->GetAverageFrameBusyMs();
+	const float FrameMs = 1000.f / FMath::Max(GameState->ArenaTickRate, 1.f);
+
+	// the game thread is the serial part every match shares, a core fits as many frames of it as the tick rate leaves room for
+	const double MatchesPerCore = BusyMs > 0.f ? NumArenas * FrameMs / BusyMs : 0.0;
+	const double MBPerMatch = ResidentMB / NumArenas;
+
+	UE_LOG(LogThePunch, Display, TEXT("%d arenas (%d throttled), %.3f ms of fighter ticks, %.3f ms of arena updates in a %.3f ms pass (%s)"),
+		NumArenas, NumThrottled, TotalFighterMs, TotalUpdateMs, GameState->GetAverageArenaPassMs(), GameState->IsArenaPassParallel() ? TEXT("parallel") : TEXT("game thread"));
+
+	UE_LOG(LogThePunch, Display, TEXT("Host: game thread busy %.3f of %.3f ms per frame, %.2f matches per core, %.1f MB per match"),
+		BusyMs, FrameMs, MatchesPerCore, MBPerMatch);
+
+	if (Args.Contains(TEXT("baseline")))
+	{
+		if (NumArenas != 1)
+		{
+			UE_LOG(LogThePunch, Error, TEXT("The one-match-per-process baseline needs a host with ?Arenas=1, this one has %d"), NumArenas);
+			return;
+		}
+
+		TSharedRef<FJsonObject> Baseline = MakeShareable(new FJsonObject());
+		Baseline->SetNumberField(TEXT("MatchesPerCore"), MatchesPerCore);
+		Baseline->SetNumberField(TEXT("MBPerMatch"), MBPerMatch);
+
+		FString BaselineText;
+		FJsonSerializer::Serialize(Baseline, TJsonWriterFactory<>::Create(&BaselineText));
+		FFileHelper::SaveStringToFile(BaselineText, *GetArenaBaselinePath());
+
+		UE_LOG(LogThePunch, Display, TEXT("One-match-per-process baseline written to %s"), *GetArenaBaselinePath());
+	}
+	else
+	{
+		TSharedPtr<FJsonObject> Baseline;
+		FString BaselineText;
+
+		if (FFileHelper::LoadFileToString(BaselineText, *GetArenaBaselinePath()) && FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineText), Baseline) && Baseline.IsValid())
+		{
+			const double BaselineMatchesPerCore = Baseline->GetNumberField(TEXT("MatchesPerCore"));
+			const double BaselineMBPerMatch = Baseline->GetNumberField(TEXT("MBPerMatch"));
+
+			UE_LOG(LogThePunch, Display, TEXT("One match per process: %.2f matches per core, %.1f MB per match; host is %.2fx the matches per core at %.2fx the memory per match"),
+				BaselineMatchesPerCore, BaselineMBPerMatch, BaselineMatchesPerCore > 0.0 ? MatchesPerCore / BaselineMatchesPerCore : 0.0,
+				BaselineMBPerMatch > 0.0 ? MBPerMatch / BaselineMBPerMatch : 0.0);
+		}
+		else
+		{
+			UE_LOG(LogThePunch, Display, TEXT("No one-match-per-process baseline, record it on a ?Arenas=1 host with ThePunch.Arenas baseline"));
+		}
+	}
+
+	UE_LOG(LogThePunch, Display, TEXT("%d/%d hit reactions simulating, skeletal mesh simulation on dedicated server %s"),
+		GameState->GetHitReactions().GetNumActive(), GameState->MaxSimulatedHitReactions,
+		UPhysicsSettings::Get()->bSimulateSkeletalMeshOnDedicatedServer ? TEXT("on") : TEXT("off"));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs DumpArenaMetricsCommand(
+	TEXT("ThePunch.Arenas"),
+	TEXT("Prints combat time, budget overruns, matches per core and memory per match of the hosted arenas. Args: baseline (record a ?Arenas=1 host as the one-match-per-process baseline)"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&DumpArenaMetrics));
+
+#endif
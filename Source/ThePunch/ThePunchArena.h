@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "FighterSpatialGrid.h"
+#include "ThePunchArena.generated.h"
+
+class AThePunchCharacter;
+
+/** per arena counters, reset with ResetMetrics */
+USTRUCT(BlueprintType)
+struct FArenaMetrics
+{
+	GENERATED_BODY()
+
+	// average combat time per frame in milliseconds (fighter ticks + arena update)
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float AverageCombatMs;
+
+	// average game thread time of the arena's fighter ticks, these run serially
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float AverageFighterMs;
+
+	// average time of UpdateCombat, on a worker once the host is large enough
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float AverageUpdateMs;
+
+	// worst frame seen since the last reset
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	float PeakCombatMs;
+
+	// frames whose combat time went over CombatBudgetMs
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 FramesOverBudget;
+
+	// frames the arena spent throttled by its budget
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 FramesThrottled;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Frames;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Attacks;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 Hits;
+
+	FArenaMetrics()
+	{
+		AverageCombatMs = 0.f;
+		AverageFighterMs = 0.f;
+		AverageUpdateMs = 0.f;
+		PeakCombatMs = 0.f;
+		FramesOverBudget = 0;
+		FramesThrottled = 0;
+		Frames = 0;
+		Attacks = 0;
+		Hits = 0;
+	}
+};
+
+/**
+ * One isolated match inside a host process. Arenas are laid out far apart in the same
+ * world, so they share every loaded combat asset (montages, attack data table)
+ * while their fighters never meet. Each arena keeps its own fighter grid and metrics.
+ * Work is split by what the engine lets run off the game thread: AThePunchGameState spreads
+ * UpdateCombat over the task graph workers once a host has enough fighters for it to pay off,
+ * and the fighters' animation updates run on the workers through the native anim instance
+ * proxy. Movement, attacks and traces are actor ticks and stay on the game thread.
+ * Every arena has a CPU budget: after BudgetFrames frames over CombatBudgetMs it is throttled,
+ * its fighters outside of combat tick at ThrottledTickInterval and it takes no new fighters,
+ * until it has been back under budget for as many frames.
+ */
+UCLASS()
+class THEPUNCH_API AThePunchArena : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AThePunchArena();
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// adds a fighter to the match and gives it a spawn transform inside the arena
+	void AddFighter(AThePunchCharacter* Fighter);
+
+	// removes a fighter from the match
+	void RemoveFighter(AThePunchCharacter* Fighter);
+
+	/** returns where the next fighter of this arena should spawn **/
+	FTransform GetSpawnTransform() const;
+
+	/** true when the arena has room for another fighter and is not throttled **/
+	bool HasFreeSlot() const;
+
+	// game thread half of the budget, applies the throttle UpdateCombat decided on to the fighters
+	void ApplyBudget();
+
+	/** true while the arena is over its CPU budget **/
+	bool IsThrottled() const { return bThrottled; }
+
+	/**
+	* UpdateCombat - rebuilds the arena grid, closes the frame's metrics and checks the budget.
+	* May run on a worker thread while the game thread waits, so it only reads actor state.
+	* The fighter ticks are not part of it, they are only timed through RecordFighterCycles.
+	*/
+	void UpdateCombat(float DeltaSeconds);
+
+	// adds game thread time spent ticking one of the arena's fighters this frame
+	void RecordFighterCycles(uint32 Cycles) { FrameCycles += Cycles; }
+
+	void RecordAttack() { ++Metrics.Attacks; }
+
+	void RecordHit() { ++Metrics.Hits; }
+
+	/** returns the fighter grid of this arena **/
+	const FFighterSpatialGrid& GetFighterGrid() const { return FighterGrid; }
+
+	const FArenaMetrics& GetMetrics() const { return Metrics; }
+
+	void ResetMetrics() { Metrics = FArenaMetrics(); }
+
+	const TArray<AThePunchCharacter*>& GetFighters() const { return Fighters; }
+
+	// fighters per match
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Arena)
+	int32 MaxFighters;
+
+	// fighters spawn on a circle of this radius around the arena center
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Arena)
+	float SpawnRadius;
+
+	// combat milliseconds per frame the arena may use, fighter ticks and update together
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Arena)
+	float CombatBudgetMs;
+
+	// consecutive frames over or under budget before the throttle changes
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Arena)
+	int32 BudgetFrames;
+
+	// tick interval of the fighters outside of combat while throttled
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Arena)
+	float ThrottledTickInterval;
+
+private:
+	UPROPERTY(Transient)
+	TArray<AThePunchCharacter*> Fighters;
+
+	FFighterSpatialGrid FighterGrid;
+
+	FArenaMetrics Metrics;
+
+	// game thread cycles of the arena's fighters, collected during the previous frame
+	uint32 FrameCycles;
+
+	// frames in a row on the other side of the budget than bThrottled says
+	int32 BudgetStreak;
+
+	bool bThrottled;
+};
@@ -1,20 +1,56 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "ThePunchCharacter.h"
-#include "HeadMountedDisplayFunctionLibrary.h"
+#include "ThePunch.h"
+#include "ThePunchGameState.h"
+#include "ThePunchGameMode.h"
+#include "ThePunchArena.h"
+#include "CombatFrameArena.h"
+#include "CombatLatency.h"
+#include "ThePunchHooks.h"
+#include "PlayerAnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/InputComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Engine/World.h"
 #include "Engine/Engine.h"
 #include "Runtime/CoreUObject/Public/UObject/ConstructorHelpers.h"
 #include "Components/SkeletalMeshComponent.h"
-#include "Sound/SoundCue.h"
 #include "Animation/AnimInstance.h"
-#include "Public/DrawDebugHelpers.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+
+DECLARE_CYCLE_STAT(TEXT("Find Best Target"), STAT_FindBestTarget, STATGROUP_ThePunch);
+
+// data table rows and mesh sockets used by the attacks, built once instead of per attack
+static const FName PunchRowKey(TEXT("Punch"));
+static const FName KickRowKey(TEXT("Kick"));
+static const FName FistLeftSocket(TEXT("fist_l_collision"));
+static const FName FistRightSocket(TEXT("fist_r_collision"));
+static const FName FootLeftSocket(TEXT("foot_l_collision"));
+static const FName FootRightSocket(TEXT("foot_r_collision"));
+
+// maps our log levels onto the engine verbosity used for the output log
+static ELogVerbosity::Type GetLogVerbosity(ELogLevel LogLevel)
+{
+	switch (LogLevel)
+	{
+	case ELogLevel::TRACE:
+		return ELogVerbosity::VeryVerbose;
+	case ELogLevel::DEBUG:
+		return ELogVerbosity::Verbose;
+	case ELogLevel::WARNING:
+		return ELogVerbosity::Warning;
+	case ELogLevel::ERROR:
+		return ELogVerbosity::Error;
+	default:
+		return ELogVerbosity::Log;
+	}
+}
 
 //////////////////////////////////////////////////////////////////////////
 // AThePunchCharacter
@@ -39,6 +75,7 @@ AThePunchCharacter::AThePunchCharacter()
 	GetCharacterMovement()->JumpZVelocity = 600.f;
 	GetCharacterMovement()->AirControl = 0.2f;
 
+#if !UE_SERVER
 	// Create a camera boom (pulls in towards the player if there is a collision)
 	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(RootComponent);
@@ -49,6 +86,7 @@ AThePunchCharacter::AThePunchCharacter()
 	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+#endif
 
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
@@ -67,36 +105,6 @@ AThePunchCharacter::AThePunchCharacter()
 		PlayerAttackDataTable = PlayerAttackMontageDataObject.Object;
 	}
 
-	// Find our Sound cue
-	static ConstructorHelpers::FObjectFinder<USoundCue> PunchSoundCueObject(TEXT("SoundCue'/Game/Resources/Audio/PunchSoundCue.PunchSoundCue'"));
-	
-	// if successful, pass it to punchSoundCue
-	if (PunchSoundCueObject.Succeeded())
-	{
-		PunchSoundCue = PunchSoundCueObject.Object;
-
-		//create a component(Audio component) called "PunchAudioComponent"
-		PunchAudioComponent = CreateDefaultSubobject<UAudioComponent>(TEXT("PunchAudioComponent"));
-		
-		// Attach to Root component of the character
-		PunchAudioComponent->SetupAttachment(RootComponent);
-	}
-
-	// Find our Punch Throw Sound cue
-	static ConstructorHelpers::FObjectFinder<USoundCue> PunchThrowSoundCueObject(TEXT("SoundCue'/Game/Resources/Audio/PunchThrowSoundCue.PunchThrowSoundCue'"));
-
-	// if successful, pass it to punchSoundCue
-	if (PunchThrowSoundCueObject.Succeeded())
-	{
-		PunchThrowSoundCue = PunchThrowSoundCueObject.Object;
-
-		//create a component(Audio component) called "PunchAudioComponent"
-		PunchThrowAudioComponent = CreateDefaultSubobject<UAudioComponent>(TEXT("PunchThrowAudioComponent"));
-
-		// Attach to Root component of the character
-		PunchThrowAudioComponent->SetupAttachment(RootComponent);
-	}
-
 	// create a Component(collision box) called "RightMeleeCollisionBox" 
 	RightMeleeCollisionBox = CreateDefaultSubobject<UBoxComponent>(TEXT("RightMeleeCollisionBox"));
 
@@ -122,33 +130,256 @@ AThePunchCharacter::AThePunchCharacter()
 	//Set animation blending on by defualt
 	IsAnimationBlended = true;
 
+	IsAttackWindowOpen = false;
+	bIsAttackScripted = false;
+	bIsParked = false;
+	LastHitReceivedTime = -BIG_NUMBER;
+	AttackMontageStartCycles = 0;
+
 	LineTraceType = ELineTraceType::PLAYER_SPREAD;
 	LineTraceDistance = 100.f;
 	LineTraceSpread = 10.f;
+
+	LockOnRadius = 1500.f;
+	LockOnMaxAngle = 60.f;
+	LockOnOcclusionChecks = 3;
+	AutoFacingRate = 720.f;
+
+	DefaultLogOutput = ELogOutput::ALL;
+
+	NativeAnimClass = UPlayerAnimInstance::StaticClass();
+
+	HitReactMontage = NULL;
+	HitReactionBone = FName(TEXT("spine_01"));
+	HitReactionImpulse = 300.f;
+	LightHitReactionTime = 0.4f;
+	KnockdownTime = 2.f;
+	IsLightHitReactionActive = false;
+	IsKnockedDown = false;
+
+	CombatNetUpdateFrequency = 60.f;
+	MovingNetUpdateFrequency = 30.f;
+	IdleNetUpdateFrequency = 5.f;
+	CombatNetInterestTime = 1.f;
+	NetDormancyDelay = 2.f;
+	LastActiveTime = 0.f;
+}
+
+void AThePunchCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// the Blueprint anim class of the mesh would run its event graph and anim graph on top of the native one
+	if (NativeAnimClass && GetMesh()->AnimClass != NativeAnimClass)
+	{
+		GetMesh()->SetAnimInstanceClass(NativeAnimClass);
+	}
+}
+
+void AThePunchCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+
+	ReleaseUnusedComponents();
+}
+
+void AThePunchCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	// a pooled fighter may have been someone else's before
+	RestoreCamera();
 }
 
 void AThePunchCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
+	ReleaseUnusedComponents();
+
 	LeftMeleeCollisionBox->OnComponentHit.AddDynamic(this, &AThePunchCharacter::OnAttackHit);
 	RightMeleeCollisionBox->OnComponentHit.AddDynamic(this, &AThePunchCharacter::OnAttackHit);
 
-	// if PunchAudioComponent and PunchSoundCue is not null
-	if (PunchAudioComponent && PunchSoundCue)
+	// the optional modules add their components, e.g. the audio of ThePunchAudio
+	FThePunchHooks::OnFighterBeginPlay.Broadcast(this);
+
+	// nothing renders on a dedicated server; only tick montages so notifies still fire,
+	// bones are refreshed while the hitboxes are live (see SetNeedsHitDetectionPose)
+	if (IsNetMode(NM_DedicatedServer))
 	{
-		// Attach PunchSoundCue to the PunchAudioComponent
-		PunchAudioComponent->SetSound(PunchSoundCue);
+		SetNeedsHitDetectionPose(false);
 	}
 
-	// if PunchThrowAudioComponent and PunchThrowSoundCue is not null
-	if (PunchThrowAudioComponent && PunchThrowSoundCue)
+	// remembered so a knocked down fighter can be put back on its capsule
+	MeshRelativeTransform = GetMesh()->GetRelativeTransform();
+	MeshCollisionProfile = GetMesh()->GetCollisionProfileName();
+
+	// make the player visible to targeting
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	if (GameState)
 	{
-		// Attach PunchThrowSoundCue to the PunchThrowAudioComponent
-		PunchThrowAudioComponent->SetSound(PunchThrowSoundCue);
+		GameState->RegisterFighter(this);
 	}
 }
 
+void AThePunchCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	if (GameState)
+	{
+		GameState->UnregisterFighter(this);
+	}
+
+	if (Arena.IsValid())
+	{
+		Arena->RemoveFighter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AThePunchCharacter::Tick(float DeltaSeconds)
+{
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	Super::Tick(DeltaSeconds);
+
+	// release the lock when the target is gone or too far away
+	if (LockOnTarget.IsValid() && (LockOnTarget->IsPendingKill() || FVector::Dist(GetActorLocation(), LockOnTarget->GetActorLocation()) > LockOnRadius * 1.25f))
+	{
+		ToggleLockOn();
+	}
+
+	// face the lock-on target all the time, the soft target only while attacking
+	AThePunchCharacter* Target = LockOnTarget.Get();
+
+	if (Target == NULL && GetCurrentMontage() != NULL)
+	{
+		Target = FacingTarget.Get();
+	}
+
+	if (Target != NULL)
+	{
+		const FVector ToTarget = Target->GetActorLocation() - GetActorLocation();
+		const FRotator DesiredRotation(0.f, ToTarget.Rotation().Yaw, 0.f);
+
+		SetActorRotation(FMath::RInterpConstantTo(GetActorRotation(), DesiredRotation, DeltaSeconds, AutoFacingRate));
+	}
+
+	if (HasAuthority() && GetNetMode() != NM_Standalone)
+	{
+		UpdateNetInterest();
+	}
+
+	// the arena reports this game thread time next to its parallel update
+	if (Arena.IsValid())
+	{
+		Arena->RecordFighterCycles(FPlatformTime::Cycles() - StartCycles);
+	}
+}
+
+void AThePunchCharacter::FellOutOfWorld(const UDamageType& DmgType)
+{
+	// only the server has a game mode; clients keep destroying their copy
+	AThePunchGameMode* GameMode = GetWorld()->GetAuthGameMode<AThePunchGameMode>();
+
+	if (GameMode && GameMode->FighterKilled(this))
+	{
+		return;
+	}
+
+	Super::FellOutOfWorld(DmgType);
+}
+
+void AThePunchCharacter::UpdateNetInterest()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	const bool bInCombat = IsInCombat();
+	const bool bIsMoving = !GetVelocity().IsNearlyZero() || IsSimulatingHitReaction();
+
+	if (bInCombat || bIsMoving)
+	{
+		LastActiveTime = Now;
+	}
+
+	NetUpdateFrequency = bInCombat ? CombatNetUpdateFrequency : (bIsMoving ? MovingNetUpdateFrequency : IdleNetUpdateFrequency);
+
+	// a dormant fighter costs no replication at all until it wakes up
+	const bool bShouldBeDormant = CanGoDormant() && Now - LastActiveTime > NetDormancyDelay;
+
+	if (bShouldBeDormant && NetDormancy != DORM_DormantAll)
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+	else if (!bShouldBeDormant && NetDormancy == DORM_DormantAll)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+}
+
+bool AThePunchCharacter::CanGoDormant() const
+{
+	// a dormant player's inputs would never reach the server to wake it up again
+	if (IsPlayerControlled() || (Controller && Controller->IsPlayerController()) || GetNetOwningPlayer() != NULL)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool AThePunchCharacter::IsInCombat() const
+{
+	return IsAttackWindowOpen || GetCurrentMontage() != NULL || GetWorld()->GetTimeSeconds() - LastHitReceivedTime < CombatNetInterestTime;
+}
+
+bool AThePunchCharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	// waiting in the actor pool, clients never see it
+	if (bIsParked)
+	{
+		return false;
+	}
+
+	// the owning connection and the viewed fighter itself always get updates
+	if (bAlwaysRelevant || IsOwnedBy(ViewTarget) || IsOwnedBy(RealViewer) || this == ViewTarget || ViewTarget == Instigator)
+	{
+		return true;
+	}
+
+	const AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+	bool bRelevant = false;
+
+	if (GameState && GameState->GetNetInterest().FindRelevance(ViewTarget, this, bRelevant))
+	{
+		return bRelevant;
+	}
+
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
+float AThePunchCharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	// the engine already weighs distance and view direction
+	float Priority = Super::GetNetPriority(ViewPos, ViewDir, Viewer, ViewTarget, InChannel, Time, bLowBandwidth);
+
+	if (IsInCombat())
+	{
+		Priority *= 2.f;
+	}
+
+	const AThePunchCharacter* ViewFighter = Cast<AThePunchCharacter>(ViewTarget);
+
+	if (ViewFighter && (ViewFighter->GetLockOnTarget() == this || LockOnTarget.Get() == ViewFighter || FacingTarget.Get() == ViewFighter))
+	{
+		Priority *= 2.f;
+	}
+
+	return Priority;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -170,34 +401,18 @@ void AThePunchCharacter::SetupPlayerInputComponent(class UInputComponent* Player
 	PlayerInputComponent->BindAxis("LookUp", this, &APawn::AddControllerPitchInput);
 	PlayerInputComponent->BindAxis("LookUpRate", this, &AThePunchCharacter::LookUpAtRate);
 
-	// handle touch devices
-	PlayerInputComponent->BindTouch(IE_Pressed, this, &AThePunchCharacter::TouchStarted);
-	PlayerInputComponent->BindTouch(IE_Released, this, &AThePunchCharacter::TouchStopped);
-
-	// VR headset functionality
-	PlayerInputComponent->BindAction("ResetVR", IE_Pressed, this, &AThePunchCharacter::OnResetVR);
-
 	// Attack Functionality
 	PlayerInputComponent->BindAction("Punch", IE_Pressed, this, &AThePunchCharacter::PunchAttack);
 	PlayerInputComponent->BindAction("Kick", IE_Released, this, &AThePunchCharacter::KickAttack);
 
 	// Line Trace
    PlayerInputComponent->BindAction("FireLineTrace", IE_Pressed, this, &AThePunchCharacter::FireLineTrace);
-}
 
-void AThePunchCharacter::OnResetVR()
-{
-	UHeadMountedDisplayFunctionLibrary::ResetOrientationAndPosition();
-}
+	// Lock On
+	PlayerInputComponent->BindAction("LockOn", IE_Pressed, this, &AThePunchCharacter::ToggleLockOn);
 
-void AThePunchCharacter::TouchStarted(ETouchIndex::Type FingerIndex, FVector Location)
-{
-		Jump();
-}
-
-void AThePunchCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVector Location)
-{
-		StopJumping();
+	// touch devices and the VR headset are bound by ThePunchVR
+	FThePunchHooks::OnSetupFighterInput.Broadcast(this, PlayerInputComponent);
 }
 
 void AThePunchCharacter::TurnAtRate(float Rate)
@@ -251,11 +466,133 @@ void AThePunchCharacter::SetIsKeyboardEnabled(bool Enabled)
 	IsKeyboardEnabled = Enabled;
 }
 
+bool AThePunchCharacter::GetIsKeyboardEnabled() const
+{
+	return IsKeyboardEnabled;
+}
+
 EAttackType AThePunchCharacter::GetCurrentAttack()
 {
 	return CurrentAttack;
 }
 
+bool AThePunchCharacter::GetIsAttackWindowOpen() const
+{
+	return IsAttackWindowOpen;
+}
+
+bool AThePunchCharacter::IsAttackScripted() const
+{
+	return bIsAttackScripted;
+}
+
+void AThePunchCharacter::SetIsAttackScripted(bool bScripted)
+{
+	bIsAttackScripted = bScripted;
+}
+
+void AThePunchCharacter::PlayThrowSound()
+{
+	FThePunchHooks::OnAttackThrown.Broadcast(this);
+}
+
+void AThePunchCharacter::ResetCombatState()
+{
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	// the script closes its window before everything else is reset
+	if (GameState)
+	{
+		GameState->GetAttackScheduler().Stop(this);
+		GameState->GetHitReactions().Remove(this);
+	}
+
+	StopPhysicalHitReaction();
+	StopAnimMontage();
+	AttackEnd();
+
+	CurrentAttack = EAttackType::MELEE_FIST;
+	IsAnimationBlended = true;
+	IsKeyboardEnabled = true;
+	bIsAttackScripted = false;
+	LastHitReceivedTime = -BIG_NUMBER;
+	AttackMontageStartCycles = 0;
+	LastActiveTime = GetWorld()->GetTimeSeconds();
+
+	LockOnTarget.Reset();
+	FacingTarget.Reset();
+	GetCharacterMovement()->bOrientRotationToMovement = true;
+	GetCharacterMovement()->StopMovementImmediately();
+
+	FThePunchHooks::OnCombatStateReset.Broadcast(this);
+}
+
+void AThePunchCharacter::SetIsParked(bool bParked)
+{
+	if (bIsParked == bParked)
+	{
+		return;
+	}
+
+	bIsParked = bParked;
+
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	if (bParked)
+	{
+		if (Controller)
+		{
+			Controller->UnPossess();
+		}
+
+		ResetCombatState();
+
+		if (GameState)
+		{
+			GameState->UnregisterFighter(this);
+		}
+
+		// the game mode puts a reused fighter into whichever arena has room
+		if (Arena.IsValid())
+		{
+			Arena->RemoveFighter(this);
+			Arena.Reset();
+		}
+
+		GetCharacterMovement()->DisableMovement();
+	}
+	else
+	{
+		GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+
+		if (GameState)
+		{
+			GameState->RegisterFighter(this);
+		}
+
+		ForceNetUpdate();
+	}
+
+	// nothing moves, animates or replicates while parked
+	GetCharacterMovement()->SetComponentTickEnabled(!bParked);
+	GetMesh()->SetComponentTickEnabled(!bParked);
+}
+
+bool AThePunchCharacter::IsParked() const
+{
+	return bIsParked;
+}
+
+float AThePunchCharacter::GetLastHitReceivedTime() const
+{
+	return LastHitReceivedTime;
+}
+
+void AThePunchCharacter::NotifyHitReceived()
+{
+	LastHitReceivedTime = GetWorld()->GetTimeSeconds();
+}
+
 // Triggers Punch Attack Animation
 void AThePunchCharacter::PunchAttack()
 {
@@ -273,37 +610,42 @@ void AThePunchCharacter::AttackInput(EAttackType AttackType)
 {
 	//Log(ELogLevel::INFO, __FUNCTION__); 
 
+	const uint64 InputCycles = FCombatLatency::Now();
+
 	if (PlayerAttackDataTable)
 	{
-		static const FString ContextString(TEXT("Player Attack Montage Context"));
+		CurrentAttack = AttackType;
 
-		// Row Name+
-		FName RowKey;
+		if (Arena.IsValid())
+		{
+			Arena->RecordAttack();
+		}
 
-		CurrentAttack = AttackType;
+		// turn toward the locked target, or the best one in view, while the attack plays
+		FacingTarget = LockOnTarget.IsValid() ? LockOnTarget.Get() : FindBestTarget();
 
 		// Attach collision components to sockets based on transformations definition
 		const FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, EAttachmentRule::SnapToTarget, EAttachmentRule::KeepWorld, false);
 
+		FName LeftSocket;
+		FName RightSocket;
+		GetAttackSocketNames(AttackType, LeftSocket, RightSocket);
+
 		switch (AttackType)
 		{
 		case EAttackType::MELEE_FIST:
-			RowKey = FName(TEXT("Punch"));
-
 			// Attach these components to the named sockets
-			LeftMeleeCollisionBox->AttachToComponent(GetMesh(), AttachmentRules, "fist_l_collision");
-			RightMeleeCollisionBox->AttachToComponent(GetMesh(), AttachmentRules, "fist_r_collision");
+			LeftMeleeCollisionBox->AttachToComponent(GetMesh(), AttachmentRules, LeftSocket);
+			RightMeleeCollisionBox->AttachToComponent(GetMesh(), AttachmentRules, RightSocket);
 
 			IsAnimationBlended = true;
 
 			IsKeyboardEnabled = true;
 			break;
 		case EAttackType::MELEE_KICK:
-			RowKey = FName(TEXT("Kick"));
-
 			// Attach these components to the named sockets
-			LeftMeleeCollisionBox->AttachToComponent(GetMesh(), AttachmentRules, "foot_l_collision");
-			RightMeleeCollisionBox->AttachToComponent(GetMesh(), AttachmentRules, "foot_r_collision");
+			LeftMeleeCollisionBox->AttachToComponent(GetMesh(), AttachmentRules, LeftSocket);
+			RightMeleeCollisionBox->AttachToComponent(GetMesh(), AttachmentRules, RightSocket);
 
 			IsAnimationBlended = false;
 
@@ -314,23 +656,85 @@ void AThePunchCharacter::AttackInput(EAttackType AttackType)
 			break;
 		}
 
-		FPlayerAttackMontage* AttackMontage = PlayerAttackDataTable->FindRow<FPlayerAttackMontage>(RowKey, ContextString, true);
+		FPlayerAttackMontage* AttackMontage = FindAttackMontage(AttackType);
 
 		if (AttackMontage)
 		{
 			// print this function on the screen, depending on the enum value
-			Log(ELogLevel::INFO, __FUNCTION__);
+			if (IsLogEnabled(ELogLevel::INFO))
+			{
+				Log(ELogLevel::INFO, ANSI_TO_TCHAR(__FUNCTION__));
+			}
 
 			//generate a random number between 1 and whatever is defined in the data table for this montage
 			int MontageSectionIndex = rand() % AttackMontage->AnimSectionCount + 1;
+			const FName SectionName = GetAttackSectionName(MontageSectionIndex);
+
+			// play random animation selected; "start_" + the random integer is the name of the section
+			if (PlayAnimMontage(AttackMontage->Montage, 1.0f, SectionName) > 0.f)
+			{
+				FCombatLatency::Record(ECombatLatency::INPUT_TO_MONTAGE, InputCycles);
+
+				AttackMontageStartCycles = FCombatLatency::Now();
+
+				// the game state resumes the attack from montage time, sections without a window keep their notifies
+				AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+				if (GameState && GameState->bUseAttackScripts)
+				{
+					GameState->GetAttackScheduler().Start(this, AttackMontage->Montage, SectionName, AttackType);
+				}
+				else
+				{
+					// scripts switched off while one was running
+					if (GameState)
+					{
+						GameState->GetAttackScheduler().Stop(this);
+					}
+
+					bIsAttackScripted = false;
+				}
+			}
+		}
+	}
+}
+
+FPlayerAttackMontage* AThePunchCharacter::FindAttackMontage(EAttackType AttackType) const
+{
+	if (PlayerAttackDataTable == NULL)
+	{
+		return NULL;
+	}
 
-			// Parse the random integer selected to string; concatenate with "start_" to get a name of an animation
-			FString MontageSection = "start_" + FString::FromInt(MontageSectionIndex);
+	static const FString ContextString(TEXT("Player Attack Montage Context"));
 
-			// play random animation selected 
-			PlayAnimMontage(AttackMontage->Montage, 1.0f, FName(*MontageSection));
-		}
+	return PlayerAttackDataTable->FindRow<FPlayerAttackMontage>(GetAttackRowKey(AttackType), ContextString, true);
+}
+
+FName AThePunchCharacter::GetAttackRowKey(EAttackType AttackType)
+{
+	return AttackType == EAttackType::MELEE_KICK ? KickRowKey : PunchRowKey;
+}
+
+void AThePunchCharacter::GetAttackSocketNames(EAttackType AttackType, FName& OutLeft, FName& OutRight)
+{
+	const bool bKick = AttackType == EAttackType::MELEE_KICK;
+
+	OutLeft = bKick ? FootLeftSocket : FistLeftSocket;
+	OutRight = bKick ? FootRightSocket : FistRightSocket;
+}
+
+FName AThePunchCharacter::GetAttackSectionName(int32 SectionIndex)
+{
+	// names are created the first time a section is played, not on every attack
+	static TArray<FName> SectionNames;
+
+	while (SectionNames.Num() <= SectionIndex)
+	{
+		SectionNames.Add(FName(*FString::Printf(TEXT("start_%d"), SectionNames.Num())));
 	}
+
+	return SectionNames[SectionIndex];
 }
 
 
@@ -346,6 +750,14 @@ void AThePunchCharacter::AttackStart()
 	// Generate Hit Events on collision
 	LeftMeleeCollisionBox->SetNotifyRigidBodyCollision(true);
 	RightMeleeCollisionBox->SetNotifyRigidBodyCollision(true);
+
+	IsAttackWindowOpen = true;
+
+	// the hitboxes follow the fist/foot sockets, which need an evaluated pose
+	if (IsNetMode(NM_DedicatedServer))
+	{
+		SetNeedsHitDetectionPose(true);
+	}
 }
 
 // Stop Attack Animation
@@ -360,57 +772,388 @@ void AThePunchCharacter::AttackEnd()
 	// Turn off Hit Events on collision
 	LeftMeleeCollisionBox->SetNotifyRigidBodyCollision(false);
 	RightMeleeCollisionBox->SetNotifyRigidBodyCollision(false);
+
+	IsAttackWindowOpen = false;
+
+	// an attack that missed has no montage to first hit time
+	AttackMontageStartCycles = 0;
+
+	if (IsNetMode(NM_DedicatedServer))
+	{
+		SetNeedsHitDetectionPose(false);
+	}
+}
+
+void AThePunchCharacter::SetNeedsHitDetectionPose(bool bNeedsPose)
+{
+	GetMesh()->VisibilityBasedAnimTickOption = bNeedsPose ? EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones : EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+}
+
+void AThePunchCharacter::ReceiveAttackHit(AThePunchCharacter* Attacker, const FVector& NormalImpulse, const FHitResult& Hit)
+{
+	const bool bKnockdown = Attacker && Attacker->GetCurrentAttack() == EAttackType::MELEE_KICK;
+
+	// push away from the attacker, the hitboxes rarely report a usable impulse of their own
+	FVector Direction = Attacker ? (GetActorLocation() - Attacker->GetActorLocation()).GetSafeNormal2D() : NormalImpulse.GetSafeNormal();
+
+	if (Direction.IsNearlyZero())
+	{
+		Direction = -GetActorForwardVector();
+	}
+
+	const FVector Impulse = Direction * HitReactionImpulse * (bKnockdown ? 2.f : 1.f);
+	const FName BoneName = Hit.BoneName != NAME_None ? Hit.BoneName : HitReactionBone;
+
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	if (GameState == NULL || !CanSimulateHitReaction())
+	{
+		PlayCannedHitReaction();
+		return;
+	}
+
+	// knockdowns and hits close to the viewer keep their physics slot over the rest
+	float Significance = bKnockdown ? 2.f : 1.f;
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	if (PlayerController && PlayerController->PlayerCameraManager)
+	{
+		const float ViewDistance = FVector::Dist(GetActorLocation(), PlayerController->PlayerCameraManager->GetCameraLocation());
+
+		Significance *= 1000.f / (1000.f + ViewDistance);
+	}
+
+	const float Duration = bKnockdown ? KnockdownTime : LightHitReactionTime;
+
+	if (!GameState->GetHitReactions().Request(this, bKnockdown ? EHitReaction::KNOCKDOWN : EHitReaction::LIGHT, Significance, Duration, GetWorld()->GetTimeSeconds()))
+	{
+		PlayCannedHitReaction();
+		return;
+	}
+
+	// a shared pose would override the simulated bodies
+	GetMesh()->SetMasterPoseComponent(NULL);
+
+	if (bKnockdown || IsKnockedDown)
+	{
+		StartKnockdown(Impulse, BoneName);
+	}
+	else
+	{
+		StartLightHitReaction(Impulse, BoneName);
+	}
+}
+
+bool AThePunchCharacter::CanSimulateHitReaction() const
+{
+	if (GetMesh()->GetPhysicsAsset() == NULL)
+	{
+		return false;
+	}
+
+	return !IsNetMode(NM_DedicatedServer) || UPhysicsSettings::Get()->bSimulateSkeletalMeshOnDedicatedServer;
+}
+
+bool AThePunchCharacter::IsSimulatingHitReaction() const
+{
+	return IsLightHitReactionActive || IsKnockedDown;
+}
+
+void AThePunchCharacter::StartLightHitReaction(const FVector& Impulse, FName BoneName)
+{
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+
+	MeshComponent->SetAllBodiesBelowSimulatePhysics(HitReactionBone, true, false);
+	MeshComponent->SetAllBodiesBelowPhysicsBlendWeight(HitReactionBone, 1.f, false, false);
+	MeshComponent->AddImpulse(Impulse, BoneName, true);
+
+	IsLightHitReactionActive = true;
+}
+
+void AThePunchCharacter::StartKnockdown(const FVector& Impulse, FName BoneName)
+{
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+
+	// the hitboxes may still be attached to the mesh
+	AttackEnd();
+	StopAnimMontage();
+
+	GetCharacterMovement()->DisableMovement();
+
+	MeshComponent->SetCollisionProfileName(TEXT("Ragdoll"));
+	MeshComponent->SetAllBodiesSimulatePhysics(true);
+	MeshComponent->SetAllBodiesPhysicsBlendWeight(1.f);
+	MeshComponent->AddImpulse(Impulse, BoneName, true);
+
+	IsLightHitReactionActive = false;
+	IsKnockedDown = true;
+}
+
+void AThePunchCharacter::SetPhysicalHitReactionBlend(float BlendWeight)
+{
+	if (IsLightHitReactionActive)
+	{
+		GetMesh()->SetAllBodiesBelowPhysicsBlendWeight(HitReactionBone, BlendWeight, false, false);
+	}
+}
+
+void AThePunchCharacter::StopPhysicalHitReaction()
+{
+	USkeletalMeshComponent* MeshComponent = GetMesh();
+
+	if (IsKnockedDown)
+	{
+		MeshComponent->SetAllBodiesSimulatePhysics(false);
+		MeshComponent->SetAllBodiesPhysicsBlendWeight(0.f);
+		MeshComponent->SetCollisionProfileName(MeshCollisionProfile);
+
+		// get up where the body landed
+		const FVector RootLocation = MeshComponent->GetComponentLocation();
+		SetActorLocation(FVector(RootLocation.X, RootLocation.Y, GetActorLocation().Z), true);
+
+		MeshComponent->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+		MeshComponent->SetRelativeTransform(MeshRelativeTransform);
+
+		GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+	}
+	else if (IsLightHitReactionActive)
+	{
+		MeshComponent->SetAllBodiesBelowSimulatePhysics(HitReactionBone, false, false);
+		MeshComponent->SetAllBodiesBelowPhysicsBlendWeight(HitReactionBone, 0.f, false, false);
+	}
+
+	IsLightHitReactionActive = false;
+	IsKnockedDown = false;
+}
+
+void AThePunchCharacter::PlayCannedHitReaction()
+{
+	if (HitReactMontage)
+	{
+		PlayAnimMontage(HitReactMontage);
+	}
 }
 
 void AThePunchCharacter::OnAttackHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-	Log(ELogLevel::WARNING, Hit.GetActor()->GetName());
+	const uint64 HitCycles = FCombatLatency::Now();
 
-	// if PunchAudioComponent is not null and if Audio is not playing
-	if (PunchAudioComponent && !PunchAudioComponent->IsPlaying())
+	// only the first hit of an attack counts, the hitboxes keep reporting while they overlap
+	if (AttackMontageStartCycles != 0)
 	{
-		//activate the sound if it has not been already activated
-		if (!PunchAudioComponent->IsActive())
-		{
-			PunchAudioComponent->Activate(true);
-		}
-		// Default pitch = 1; 
-		//Set random pitch btw 1 and 1.3
-		PunchAudioComponent->SetPitchMultiplier(FMath::RandRange(1.0f, 1.3f));
-		// play Audio
-		PunchAudioComponent->Play(0.f);
+		FCombatLatency::Record(ECombatLatency::MONTAGE_TO_HIT, AttackMontageStartCycles);
+
+		AttackMontageStartCycles = 0;
+	}
+
+	// only build the message when it will be printed somewhere
+	if (Hit.GetActor() && IsLogEnabled(ELogLevel::WARNING))
+	{
+		FCombatFrameString Message;
+		Message.Append(Hit.GetActor()->GetFName());
+
+		Log(ELogLevel::WARNING, *Message);
+	}
+
+	// let the victim keep its own pose while it reacts
+	AThePunchCharacter* Victim = Cast<AThePunchCharacter>(OtherActor);
+
+	if (Victim)
+	{
+		Victim->NotifyHitReceived();
+		Victim->ReceiveAttackHit(this, NormalImpulse, Hit);
+	}
+
+	if (Arena.IsValid())
+	{
+		Arena->RecordHit();
+	}
+
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	// a scripted attack closes its window on the first hit
+	if (GameState && bIsAttackScripted)
+	{
+		GameState->GetAttackScheduler().NotifyHit(this);
+	}
+
+	if (GameState)
+	{
+		GameState->PlayImpactEffect(Hit.ImpactPoint, Hit.ImpactNormal);
+	}
+
+	if (GameState && GameState->GetMatchStateExport().IsOpen())
+	{
+		GameState->GetMatchStateExport().RecordHit(this, Victim, Hit.ImpactPoint, GetWorld()->GetTimeSeconds());
+	}
+
+	// the punch sound of ThePunchAudio records the hit to audio latency from HitCycles
+	FThePunchHooks::OnAttackHit.Broadcast(this, HitCycles);
+}
+bool AThePunchCharacter::IsLogEnabled(ELogLevel LogLevel) const
+{
+	if ((DefaultLogOutput == ELogOutput::ALL || DefaultLogOutput == ELogOutput::SCREEN) && IsScreenLogAvailable())
+	{
+		return true;
+	}
+
+	if (DefaultLogOutput == ELogOutput::ALL || DefaultLogOutput == ELogOutput::OUTPUT_LOG)
+	{
+		return !LogThePunch.IsSuppressed(GetLogVerbosity(LogLevel));
+	}
+
+	return false;
+}
+
+void AThePunchCharacter::ReleaseUnusedComponents()
+{
+	// only a local player looks through the camera; servers only learn who controls the fighter
+	// in PossessedBy, an unpossessed fighter keeps its camera until then
+	const bool bUnseen = IsNetMode(NM_DedicatedServer) || Role == ROLE_SimulatedProxy || (Controller && !Controller->IsLocalPlayerController());
+
+	if (!bUnseen)
+	{
+		return;
+	}
+
+	if (FollowCamera)
+	{
+		FollowCamera->DestroyComponent();
+		FollowCamera = NULL;
+	}
+
+	if (CameraBoom)
+	{
+		CameraBoom->DestroyComponent();
+		CameraBoom = NULL;
 	}
 }
-void AThePunchCharacter::Log(ELogLevel LogLevel, FString Message)
+
+void AThePunchCharacter::RestoreCamera()
 {
-	Log(LogLevel, Message, ELogOutput::ALL);
+	const AThePunchCharacter* Defaults = GetClass()->GetDefaultObject<AThePunchCharacter>();
+
+	// server builds have no camera to restore
+	if (FollowCamera || Defaults->CameraBoom == NULL || Defaults->FollowCamera == NULL)
+	{
+		return;
+	}
+
+	// the defaults are the templates, so Blueprint changes to the boom and camera carry over
+	CameraBoom = NewObject<USpringArmComponent>(this, NAME_None, RF_NoFlags, Defaults->CameraBoom);
+	CameraBoom->SetupAttachment(RootComponent);
+	CameraBoom->RegisterComponent();
+
+	FollowCamera = NewObject<UCameraComponent>(this, NAME_None, RF_NoFlags, Defaults->FollowCamera);
+	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
+	FollowCamera->RegisterComponent();
+}
+
+void AThePunchCharacter::GetCombatAssets(TArray<UObject*>& OutAssets) const
+{
+	OutAssets.Add(MeleeFistAttackMontage);
+	OutAssets.Add(PlayerAttackDataTable);
+	OutAssets.Add(HitReactMontage);
+}
+
+bool AThePunchCharacter::IsScreenLogAvailable() const
+{
+#if UE_SERVER
+	return false;
+#else
+	return GEngine != NULL && !IsNetMode(NM_DedicatedServer);
+#endif
+}
+
+void AThePunchCharacter::Log(ELogLevel LogLevel, const TCHAR* Message)
+{
+	Log(LogLevel, Message, DefaultLogOutput);
+}
+
+void AThePunchCharacter::Log(ELogLevel LogLevel, const FString& Message)
+{
+	Log(LogLevel, *Message, DefaultLogOutput);
 }
 
 void AThePunchCharacter::FireLineTrace()
 {
-	Log(ELogLevel::WARNING, __FUNCTION__);
+	if (IsLogEnabled(ELogLevel::WARNING))
+	{
+		Log(ELogLevel::WARNING, ANSI_TO_TCHAR(__FUNCTION__));
+	}
 
 	FVector Start;
 	FVector End;
+	FCollisionQueryParams TraceParams;
+
+	PrepareLineTrace(Start, End, TraceParams);
+
+	FHitResult HitDetails = FHitResult(ForceInit);
+
+	const uint64 TraceCycles = FCombatLatency::Now();
+
+	bool bIsHit = GetWorld()->LineTraceSingleByChannel(HitDetails, Start, End, ECC_EngineTraceChannel3, TraceParams);
+
+	FCombatLatency::Record(ECombatLatency::LINE_TRACE, TraceCycles);
+
+	if (bIsHit)
+	{
+		Log(ELogLevel::INFO, TEXT("We hit something"));
+
+		if (HitDetails.Actor.IsValid() && IsLogEnabled(ELogLevel::WARNING))
+		{
+			FCombatFrameString ActorName;
+			ActorName.Append(HitDetails.Actor->GetFName());
+
+			Log(ELogLevel::WARNING, *ActorName);
+		}
+
+		if (IsLogEnabled(ELogLevel::DEBUG))
+		{
+			FCombatFrameString Distance;
+			Distance.Append(HitDetails.Distance);
 
+			Log(ELogLevel::DEBUG, *Distance);
+		}
+
+		AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+		if (GameState)
+		{
+			GameState->PlayImpactEffect(HitDetails.ImpactPoint, HitDetails.ImpactNormal);
+		}
+	}
+	else
+	{
+		Log(ELogLevel::WARNING, TEXT("We hit nothing"));
+	}
+
+	// drawn by ThePunchDebug
+	FThePunchHooks::OnLineTraceFinished.Broadcast(this, Start, End, bIsHit ? &HitDetails : NULL);
+}
+
+void AThePunchCharacter::PrepareLineTrace(FVector& OutStart, FVector& OutEnd, FCollisionQueryParams& OutParams) const
+{
 	const float Spread = FMath::DegreesToRadians(LineTraceSpread * 0.5);
 
 	if (LineTraceType == ELineTraceType::CAMERA_SINGLE || LineTraceType == ELineTraceType::CAMERA_SPREAD)
 	{
-		// get camera point of view
-		FVector CameraLocation = FollowCamera->GetComponentLocation();
-		FRotator CameraRotation = FollowCamera->GetComponentRotation();
+		// get camera point of view, the eyes when there is no camera (dedicated server)
+		FVector CameraLocation;
+		FRotator CameraRotation;
+
+		GetTargetingViewPoint(CameraLocation, CameraRotation);
 
-		Start = CameraLocation;
+		OutStart = CameraLocation;
 
 		if (LineTraceType == ELineTraceType::CAMERA_SPREAD)
 		{
-			End = CameraLocation + FMath::VRandCone(CameraRotation.Vector(), Spread, Spread) * LineTraceDistance;
+			OutEnd = CameraLocation + FMath::VRandCone(CameraRotation.Vector(), Spread, Spread) * LineTraceDistance;
 		}
 		else
 		{
 			// Ending location where the camera is facing based on the line distance
-			End = CameraLocation + (CameraRotation.Vector() * LineTraceDistance);
+			OutEnd = CameraLocation + (CameraRotation.Vector() * LineTraceDistance);
 		}
 	}
 	else if (LineTraceType == ELineTraceType::PLAYER_SINGLE || LineTraceType == ELineTraceType::PLAYER_SPREAD)
@@ -420,44 +1163,160 @@ void AThePunchCharacter::FireLineTrace()
 
 		GetActorEyesViewPoint(PlayerEyesLocation, PlayerEyesRotation);
 
-		Start = PlayerEyesLocation;
+		OutStart = PlayerEyesLocation;
 
 		if (LineTraceType == ELineTraceType::PLAYER_SPREAD)
 		{
-			End = PlayerEyesLocation + FMath::VRandCone(PlayerEyesRotation.Vector(), Spread, Spread) * LineTraceDistance;
+			OutEnd = PlayerEyesLocation + FMath::VRandCone(PlayerEyesRotation.Vector(), Spread, Spread) * LineTraceDistance;
 		}
 		else
 		{
-			End = PlayerEyesLocation + (PlayerEyesRotation.Vector() * LineTraceDistance);
+			OutEnd = PlayerEyesLocation + (PlayerEyesRotation.Vector() * LineTraceDistance);
 		}
 	}
 
-	FHitResult HitDetails = FHitResult(ForceInit);
+	static const FName LineTraceTag(TEXT("LineTraceParameters"));
 
-	FCollisionQueryParams TraceParams(FName(TEXT("LineTraceParameters")), true, NULL);
-	TraceParams.bTraceComplex = true;
-	TraceParams.bReturnPhysicalMaterial = true;
-	bool bIsHit = GetWorld()->LineTraceSingleByChannel(HitDetails, Start, End, ECC_EngineTraceChannel3, TraceParams);
+	OutParams = FCollisionQueryParams(LineTraceTag, true, NULL);
+	OutParams.bTraceComplex = true;
+	OutParams.bReturnPhysicalMaterial = true;
+}
 
-	if (bIsHit)
+void AThePunchCharacter::ToggleLockOn()
+{
+	if (LockOnTarget.IsValid())
+	{
+		LockOnTarget.Reset();
+	}
+	else
+	{
+		LockOnTarget = FindBestTarget();
+	}
+
+	// while locked the player faces the target instead of its movement direction
+	GetCharacterMovement()->bOrientRotationToMovement = !LockOnTarget.IsValid();
+}
+
+AThePunchCharacter* AThePunchCharacter::GetLockOnTarget() const
+{
+	return LockOnTarget.Get();
+}
+
+AThePunchArena* AThePunchCharacter::GetArena() const
+{
+	return Arena.Get();
+}
+
+void AThePunchCharacter::SetArena(AThePunchArena* NewArena)
+{
+	Arena = NewArena;
+}
+
+const FFighterSpatialGrid* AThePunchCharacter::GetFighterGrid() const
+{
+	if (Arena.IsValid())
+	{
+		return &Arena->GetFighterGrid();
+	}
+
+	const AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	return GameState ? &GameState->GetFighterGrid() : NULL;
+}
+
+AThePunchCharacter* AThePunchCharacter::FindBestTarget() const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FindBestTarget);
+
+	const FFighterSpatialGrid* FighterGrid = GetFighterGrid();
+
+	if (FighterGrid == NULL)
+	{
+		return NULL;
+	}
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+
+	GetTargetingViewPoint(ViewLocation, ViewRotation);
+
+	// only the yaw of the view matters, a pitched camera should still find targets
+	const FVector ViewDirection = ViewRotation.Vector().GetSafeNormal2D();
+	const float MinCosAngle = FMath::Cos(FMath::DegreesToRadians(LockOnMaxAngle));
+
+	// only look at the grid cells around the player instead of every fighter
+	TArray<AThePunchCharacter*, FCombatFrameAllocator> Nearby;
+	FighterGrid->QueryRadius(GetActorLocation(), LockOnRadius, Nearby);
+
+	struct FTargetCandidate
+	{
+		AThePunchCharacter* Fighter;
+		float Score;
+	};
+
+	TArray<FTargetCandidate, TInlineAllocator<16>> Candidates;
+
+	for (AThePunchCharacter* Fighter : Nearby)
+	{
+		if (Fighter == this || Fighter->IsPendingKill())
+		{
+			continue;
+		}
+
+		const FVector Direction = (Fighter->GetActorLocation() - ViewLocation).GetSafeNormal2D();
+		const float CosAngle = FVector::DotProduct(Direction, ViewDirection);
+
+		if (CosAngle < MinCosAngle)
+		{
+			continue;
+		}
+
+		// 1 when straight ahead / right next to the player, 0 at the edge of the cone / radius
+		const float AngleScore = (CosAngle - MinCosAngle) / FMath::Max(1.f - MinCosAngle, KINDA_SMALL_NUMBER);
+		const float DistanceScore = 1.f - FVector::Dist(GetActorLocation(), Fighter->GetActorLocation()) / LockOnRadius;
+
+		Candidates.Add(FTargetCandidate{ Fighter, AngleScore * 0.6f + DistanceScore * 0.4f });
+	}
+
+	Candidates.Sort([](const FTargetCandidate& A, const FTargetCandidate& B) { return A.Score > B.Score; });
+
+	// occlusion is the expensive part, trace only the best few
+	static const FName LockOnTraceTag(TEXT("LockOnOcclusion"));
+	const int32 NumChecks = FMath::Min(Candidates.Num(), LockOnOcclusionChecks);
+
+	for (int32 Index = 0; Index < NumChecks; ++Index)
+	{
+		AThePunchCharacter* Candidate = Candidates[Index].Fighter;
+
+		FCollisionQueryParams TraceParams(LockOnTraceTag, false, this);
+		TraceParams.AddIgnoredActor(Candidate);
+
+		if (!GetWorld()->LineTraceTestByChannel(ViewLocation, Candidate->GetActorLocation(), ECC_Visibility, TraceParams))
+		{
+			return Candidate;
+		}
+	}
+
+	return NULL;
+}
+
+void AThePunchCharacter::GetTargetingViewPoint(FVector& OutLocation, FRotator& OutRotation) const
+{
+	if (FollowCamera)
 	{
-		Log(ELogLevel::INFO, "We hit something");
-		DrawDebugLine(GetWorld(), Start, End, FColor::Green, false, 5.f, ECC_WorldStatic, 1.f);
-		Log(ELogLevel::WARNING, HitDetails.Actor->GetName());
-		Log(ELogLevel::DEBUG, FString::SanitizeFloat(HitDetails.Distance));
-		DrawDebugBox(GetWorld(), HitDetails.ImpactPoint, FVector(2.f, 2.f, 2.f), FColor::Blue, false, 5.f, ECC_WorldStatic, 1.f);
+		OutLocation = FollowCamera->GetComponentLocation();
+		OutRotation = FollowCamera->GetComponentRotation();
 	}
 	else
 	{
-		Log(ELogLevel::WARNING, "We hit nothing");
-		DrawDebugLine(GetWorld(), Start, End, FColor::Purple, false, 5.f, ECC_WorldStatic, 1.f);
+		GetActorEyesViewPoint(OutLocation, OutRotation);
 	}
 }
 
-void AThePunchCharacter::Log(ELogLevel LogLevel, FString Message, ELogOutput LogOutput)
+void AThePunchCharacter::Log(ELogLevel LogLevel, const TCHAR* Message, ELogOutput LogOutput)
 {
-	// only print when screen is selected, and the GEngine is available
-	if ((LogOutput == ELogOutput::ALL || LogOutput == ELogOutput::SCREEN) && GEngine)
+	// only print when screen is selected, and there is a screen to print on
+	if ((LogOutput == ELogOutput::ALL || LogOutput == ELogOutput::SCREEN) && IsScreenLogAvailable())
 	{
 		//default color
 		FColor LogColor = FColor::Cyan;
@@ -494,22 +1353,22 @@ void AThePunchCharacter::Log(ELogLevel LogLevel, FString Message, ELogOutput Log
 		switch (LogLevel)
 		{
 		case ELogLevel::TRACE:
-			UE_LOG(LogTemp, VeryVerbose, TEXT("%s"), *Message)
+			UE_LOG(LogThePunch, VeryVerbose, TEXT("%s"), Message)
 			break;
 		case ELogLevel::DEBUG:
-			UE_LOG(LogTemp, Verbose, TEXT("%s"), *Message)
+			UE_LOG(LogThePunch, Verbose, TEXT("%s"), Message)
 			break;
 		case ELogLevel::INFO:
-			UE_LOG(LogTemp, Log, TEXT("%s"), *Message)
+			UE_LOG(LogThePunch, Log, TEXT("%s"), Message)
 			break;
 		case ELogLevel::WARNING:
-			UE_LOG(LogTemp, Warning, TEXT("%s"), *Message)
+			UE_LOG(LogThePunch, Warning, TEXT("%s"), Message)
 			break;
 		case ELogLevel::ERROR:
-			UE_LOG(LogTemp, Error, TEXT("%s"), *Message)
+			UE_LOG(LogThePunch, Error, TEXT("%s"), Message)
 			break;
 		default:
-			UE_LOG(LogTemp, Log, TEXT("%s"), *Message)
+			UE_LOG(LogThePunch, Log, TEXT("%s"), Message)
 			break;
 		}
 	}
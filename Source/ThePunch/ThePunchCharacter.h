@@ -5,7 +5,6 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Components/BoxComponent.h"
-#include "Components/AudioComponent.h"
 
 #include "Engine/DataTable.h"
 
@@ -84,7 +83,7 @@ enum class EAttackType : uint8
 };
 
 UCLASS(config=Game)
-class AThePunchCharacter : public ACharacter
+class THEPUNCH_API AThePunchCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
@@ -96,6 +95,10 @@ class AThePunchCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent* FollowCamera;
 
+	// replaces the mesh's Blueprint anim class so the native graph runs without the Blueprint VM; none keeps the Blueprint
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, meta = (AllowPrivateAccess = "true"))
+	TSubclassOf<class UAnimInstance> NativeAnimClass;
+
 	//melee fist attack montage
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, meta = (AllowPrivateAccess = "true"))
 	class UAnimMontage* MeleeFistAttackMontage;
@@ -104,13 +107,6 @@ class AThePunchCharacter : public ACharacter
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation, meta = (AllowPrivateAccess = "true"))
 	class UDataTable* PlayerAttackDataTable;
 
-	// load sound cue
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Audio, meta = (AllowPrivateAccess = "true"))
-	class USoundCue* PunchSoundCue;
-
-	// load sound cue
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Audio, meta = (AllowPrivateAccess = "true"))
-	class USoundCue* PunchThrowSoundCue;
 		
 	// Right fist collision box
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Collision, meta = (AllowPrivateAccess = "true"))
@@ -131,9 +127,45 @@ public:
 	// Triggers Attack animation based on user input
 	void AttackInput(EAttackType AttackType);
 
+	// looks up the data table row of an attack type, null when there is no table or row
+	FPlayerAttackMontage* FindAttackMontage(EAttackType AttackType) const;
+
+	// returns the data table row an attack type is played from
+	static FName GetAttackRowKey(EAttackType AttackType);
+
+	// returns the montage section name "start_<SectionIndex>"
+	static FName GetAttackSectionName(int32 SectionIndex);
+
+	// returns the mesh sockets the melee hitboxes follow during an attack
+	static void GetAttackSocketNames(EAttackType AttackType, FName& OutLeft, FName& OutRight);
+
+	// swaps in NativeAnimClass before the mesh starts animating
+	virtual void PostInitializeComponents() override;
+
+	// a fighter possessed by a remote player or an AI drops its camera
+	virtual void PossessedBy(AController* NewController) override;
+
+	// called where the possessing player is local; brings the camera back if it was dropped
+	virtual void PawnClientRestart() override;
+
 	// called when the game begins or when the player is spawned
 	virtual void BeginPlay() override;
 
+	// called when the player is destroyed or the level is unloaded
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// called every frame; keeps the player facing its lock-on target
+	virtual void Tick(float DeltaSeconds) override;
+
+	// on the server the game mode parks the fighter in the actor pool instead of destroying it
+	virtual void FellOutOfWorld(const class UDamageType& DmgType) override;
+
+	// only fighters near the connection's view target are relevant, see FFighterNetInterest
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+	// fighters in combat, and fighters fighting the viewer, get replicated first
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, class AActor* Viewer, AActor* ViewTarget, class UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseTurnRate;
@@ -160,10 +192,94 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Animation)
 		void SetIsKeyboardEnabled(bool Enabled);
 
+	/** returns false while a kick has locked the keyboard **/
+	UFUNCTION(BlueprintCallable, Category = Animation)
+	bool GetIsKeyboardEnabled() const;
+
 	/** returns the current attack that the player is perfoming **/
 	UFUNCTION(BlueprintCallable, Category = Animation)
 	EAttackType GetCurrentAttack();
 
+	/** returns true between AttackStart and AttackEnd, while the hitboxes are live **/
+	UFUNCTION(BlueprintCallable, Category = Animation)
+	bool GetIsAttackWindowOpen() const;
+
+	/** returns true when an attack script drives the current attack and its notifies are ignored **/
+	bool IsAttackScripted() const;
+
+	// called by FAttackScheduler when it takes over or gives back the current attack
+	void SetIsAttackScripted(bool bScripted);
+
+	// swing sound of the current attack, played by ThePunchAudio
+	void PlayThrowSound();
+
+	/**
+	* ResetCombatState - puts a reused fighter back into the state of a fresh spawn:
+	* no montage, attack or hit reaction, no targets and the keyboard enabled
+	*/
+	void ResetCombatState();
+
+	/**
+	* SetIsParked - takes the fighter out of the match while it waits in FActorPool, or puts it back;
+	* a parked fighter is not registered, does not move, animate or replicate
+	* @param bParked true when the fighter goes into the pool
+	*/
+	void SetIsParked(bool bParked);
+
+	/** returns true while the fighter waits in the actor pool **/
+	bool IsParked() const;
+
+	/** returns the world time the player was last hit by an opponent **/
+	float GetLastHitReceivedTime() const;
+
+	// called on the victim when an opponent's attack connects
+	void NotifyHitReceived();
+
+	/**
+	* ReceiveAttackHit - reacts to an opponent's attack; kicks knock the victim down, punches
+	* blend the upper body into physics. Without a free physics slot, or on a dedicated server
+	* that does not simulate skeletal meshes, HitReactMontage plays instead.
+	* @param Attacker the fighter whose attack connected
+	* @param NormalImpulse impulse of the hit event
+	* @param Hit the hit result on the victim
+	*/
+	void ReceiveAttackHit(AThePunchCharacter* Attacker, const FVector& NormalImpulse, const FHitResult& Hit);
+
+	/** returns true while the player attacks or was hit within CombatNetInterestTime **/
+	bool IsInCombat() const;
+
+	/** returns true while a physics hit reaction drives the mesh **/
+	bool IsSimulatingHitReaction() const;
+
+	// sets how much of the upper body follows physics during a light hit reaction
+	void SetPhysicalHitReactionBlend(float BlendWeight);
+
+	// ends a physics hit reaction, a knocked down fighter gets back up
+	void StopPhysicalHitReaction();
+
+	// plays HitReactMontage, used when the reaction is not simulated
+	void PlayCannedHitReaction();
+
+	// played on hits that are not simulated
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Reaction")
+		class UAnimMontage* HitReactMontage;
+
+	// bodies below this bone simulate during a light hit reaction
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Reaction")
+		FName HitReactionBone;
+
+	// velocity change in cm/s given to the hit body, doubled for knockdowns
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Reaction")
+		float HitReactionImpulse;
+
+	// seconds a light hit blends from physics back to animation
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Reaction")
+		float LightHitReactionTime;
+
+	// seconds a knocked down fighter stays in ragdoll
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Reaction")
+		float KnockdownTime;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Line Trace")
 		ELineTraceType LineTraceType;
 
@@ -175,10 +291,97 @@ public:
 
 	void FireLineTrace();
 
-protected:
+	/** computes the segment and query parameters FireLineTrace traces with **/
+	void PrepareLineTrace(FVector& OutStart, FVector& OutEnd, FCollisionQueryParams& OutParams) const;
+
+	/** locks on to the best target in front of the camera, or releases the current lock **/
+	void ToggleLockOn();
+
+	/**
+	* FindBestTarget - scores nearby fighters by angle to the camera and distance;
+	* only the best LockOnOcclusionChecks candidates are traced for occlusion
+	* @return the best visible opponent, or null
+	*/
+	AThePunchCharacter* FindBestTarget() const;
+
+	/** returns the opponent the player is locked on to **/
+	UFUNCTION(BlueprintCallable, Category = "Lock On")
+	AThePunchCharacter* GetLockOnTarget() const;
+
+	/** returns the arena the player fights in when the process hosts several matches **/
+	class AThePunchArena* GetArena() const;
+
+	// called by AThePunchArena::AddFighter
+	void SetArena(class AThePunchArena* NewArena);
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Lock On")
+		float LockOnRadius;
+
+	// half angle of the cone in front of the camera that targets must be in
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Lock On")
+		float LockOnMaxAngle;
+
+	// how many of the best scored candidates are checked for occlusion
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Lock On")
+		int32 LockOnOcclusionChecks;
+
+	// deg/sec the player turns toward its target while locked on or attacking
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Lock On")
+		float AutoFacingRate;
+
+	// replication rate while attacking or being attacked
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Replication)
+		float CombatNetUpdateFrequency;
 
-	/** Resets HMD orientation in VR. */
-	void OnResetVR();
+	// replication rate while moving outside of combat
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Replication)
+		float MovingNetUpdateFrequency;
+
+	// replication rate of an idle fighter before it goes dormant
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Replication)
+		float IdleNetUpdateFrequency;
+
+	// seconds a hit keeps the victim at the combat replication rate
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Replication)
+		float CombatNetInterestTime;
+
+	// seconds of idling before the fighter stops replicating until it does something again
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Replication)
+		float NetDormancyDelay;
+
+	// where Log sends messages when no output is given
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Debug)
+		ELogOutput DefaultLogOutput;
+
+	/** returns true when a message at LogLevel reaches any output; check it before building a message **/
+	bool IsLogEnabled(ELogLevel LogLevel) const;
+
+	/** returns false for fighters a player drives; their moves and RPCs need the channel dormancy closes **/
+	bool CanGoDormant() const;
+
+	/**
+	* Log - prints a message to the default log outputs with a specific color
+	* @param LogLevel {@see ELogLevel} affects color of log
+	* @param Message the message for display
+	*/
+	void Log(ELogLevel LogLevel, const TCHAR* Message);
+
+	/**
+	* Log - prints a message to the default log outputs with a specific color
+	* @param LogLevel {@see ELogLevel} affects color of log
+	* @param FString the message for display
+	*/
+	void Log(ELogLevel LogLevel, const FString& Message);
+
+	/**
+	* Log - prints a message to all the log outputs with a specific color
+	* @param LogLevel {@see ELogLevel} affects color of log
+	* @param Message the message for display
+	* @param ELogOutput - All, Output Log or Screen
+	*/
+	void Log(ELogLevel LogLevel, const TCHAR* Message, ELogOutput LogOutput);
+
+protected:
 
 	/** Called for forwards/backward input */
 	void MoveForward(float Value);
@@ -198,12 +401,6 @@ protected:
 	 */
 	void LookUpAtRate(float Rate);
 
-	/** Handler for when a touch input begins. */
-	void TouchStarted(ETouchIndex::Type FingerIndex, FVector Location);
-
-	/** Handler for when a touch input stops. */
-	void TouchStopped(ETouchIndex::Type FingerIndex, FVector Location);
-
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
@@ -214,13 +411,15 @@ public:
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns the data table attack montages are looked up in **/
+	FORCEINLINE class UDataTable* GetPlayerAttackDataTable() const { return PlayerAttackDataTable; }
+	/** Returns RightMeleeCollisionBox subobject, both hitboxes have the same size **/
+	FORCEINLINE class UBoxComponent* GetRightMeleeCollisionBox() const { return RightMeleeCollisionBox; }
 
-	UAudioComponent* PunchThrowAudioComponent;
-
+	// adds the montages and data table of this fighter to OutAssets, see UCombatAssetSet
+	void GetCombatAssets(TArray<UObject*>& OutAssets) const;
 
 private:
-	UAudioComponent* PunchAudioComponent;
-
 	// structure for PlayerAttackMontage Data Table
 	FPlayerAttackMontage* AttackMontage;
 
@@ -234,19 +433,71 @@ private:
 
 	bool IsKeyboardEnabled;
 
+	bool IsAttackWindowOpen;
 
-	/**
-	* Log - prints a message to all the log outputs with a specific color
-	* @param LogLevel {@see ELogLevel} affects color of log
-	* @param FString the message for display
-	*/
-	void Log(ELogLevel LogLevel, FString Message);
+	bool bIsAttackScripted;
+
+	bool bIsParked;
+
+	float LastHitReceivedTime;
+
+	// FPlatformTime::Cycles64 when the current attack montage started, 0 once its first hit was recorded
+	uint64 AttackMontageStartCycles;
+
+	// arena of this fighter in host mode; targeting only looks at fighters of the same arena
+	TWeakObjectPtr<class AThePunchArena> Arena;
+
+	// fighter grid of the arena, or of the whole match outside host mode
+	const class FFighterSpatialGrid* GetFighterGrid() const;
+
+	// opponent selected with ToggleLockOn
+	TWeakObjectPtr<AThePunchCharacter> LockOnTarget;
+
+	// opponent the current attack turns toward when there is no lock
+	TWeakObjectPtr<AThePunchCharacter> FacingTarget;
+
+	// camera point of view when there is a camera, eyes otherwise
+	void GetTargetingViewPoint(FVector& OutLocation, FRotator& OutRotation) const;
+
+	// on a dedicated server, switches between montage-only ticking and full pose evaluation
+	void SetNeedsHitDetectionPose(bool bNeedsPose);
+
+	// destroys the camera and boom of a fighter no local player looks through
+	void ReleaseUnusedComponents();
+
+	// creates the camera and boom again from the class defaults when a local player takes the fighter over
+	void RestoreCamera();
+
+	// false on servers, on-screen messages are never seen there
+	bool IsScreenLogAvailable() const;
 
 	/**
-	* Log - prints a message to all the log outputs with a specific color
-	* @param LogLevel {@see ELogLevel} affects color of log
-	* @param FString the message for display
-	* @param ELogOutput - All, Output Log or Screen
+	* UpdateNetInterest - picks the replication rate from the combat state and puts idle fighters to sleep, server only.
+	* The engine keeps one NetUpdateFrequency per actor for all connections, so this is the rate the most
+	* interested viewer needs; per connection, FFighterNetInterest decides who gets the fighter at all and
+	* GetNetPriority orders it within each connection's bandwidth.
 	*/
-	void Log(ELogLevel LogLevel, FString Message, ELogOutput LogOutput);
+	void UpdateNetInterest();
+
+	// world time the fighter last moved, attacked or was hit
+	float LastActiveTime;
+
+	// true when this process may simulate the mesh at all
+	bool CanSimulateHitReaction() const;
+
+	// puts the whole mesh into ragdoll
+	void StartKnockdown(const FVector& Impulse, FName BoneName);
+
+	// blends the bodies below HitReactionBone into physics
+	void StartLightHitReaction(const FVector& Impulse, FName BoneName);
+
+	bool IsLightHitReactionActive;
+
+	bool IsKnockedDown;
+
+	// mesh placement and collision restored when a knocked down fighter gets up
+	FTransform MeshRelativeTransform;
+
+	FName MeshCollisionProfile;
+
 };
\ No newline at end of file
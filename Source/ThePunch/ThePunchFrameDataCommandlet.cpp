@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchFrameDataCommandlet.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchGameMode.h"
+#include "AttackFrameData.h"
+#include "Animation/AnimMontage.h"
+#include "Engine/DataTable.h"
+#include "UObject/Package.h"
+
+UThePunchFrameDataCommandlet::UThePunchFrameDataCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UThePunchFrameDataCommandlet::Main(const FString& Params)
+{
+	float TickRate = 60.f;
+	FParse::Value(*Params, TEXT("TickRate="), TickRate);
+
+	const bool bFull = FParse::Param(*Params, TEXT("Full"));
+	const bool bStrict = FParse::Param(*Params, TEXT("Strict"));
+
+	if (TickRate <= 0.f)
+	{
+		UE_LOG(LogThePunch, Error, TEXT("TickRate must be above 0"));
+		return 1;
+	}
+
+	// the blueprint fighter may override the data table
+	const TSubclassOf<APawn> PawnClass = GetDefault<AThePunchGameMode>()->DefaultPawnClass;
+	UClass* FighterClass = PawnClass && PawnClass->IsChildOf(AThePunchCharacter::StaticClass()) ? *PawnClass : AThePunchCharacter::StaticClass();
+	const UDataTable* AttackTable = FighterClass->GetDefaultObject<AThePunchCharacter>()->GetPlayerAttackDataTable();
+
+	if (AttackTable == NULL)
+	{
+		UE_LOG(LogThePunch, Error, TEXT("%s has no attack data table"), *FighterClass->GetName());
+		return 1;
+	}
+
+	// rows may share a montage, it is analyzed once with the most sections any row plays
+	TMap<UAnimMontage*, int32> MontageSections;
+	static const FString ContextString(TEXT("Frame Data Commandlet"));
+
+	for (const FName& Row : AttackTable->GetRowNames())
+	{
+		const FPlayerAttackMontage* AttackMontage = AttackTable->FindRow<FPlayerAttackMontage>(Row, ContextString, false);
+
+		if (AttackMontage == NULL || AttackMontage->Montage == NULL)
+		{
+			UE_LOG(LogThePunch, Warning, TEXT("%s has no montage"), *Row.ToString());
+			continue;
+		}
+
+		int32& SectionCount = MontageSections.FindOrAdd(AttackMontage->Montage);
+		SectionCount = FMath::Max(SectionCount, AttackMontage->AnimSectionCount);
+	}
+
+	FAttackFrameDataTable& Table = FAttackFrameDataTable::Get();
+
+	if (bFull)
+	{
+		Table.RemoveMontagesExcept(TSet<FName>());
+	}
+
+	Table.SetTickRate(TickRate);
+
+	TSet<FName> PackageNames;
+	int32 Analyzed = 0;
+	int32 Reused = 0;
+	int32 Flagged = 0;
+
+	for (const TPair<UAnimMontage*, int32>& Montage : MontageSections)
+	{
+		const UPackage* Package = Montage.Key->GetOutermost();
+		const FName PackageName = Package->GetFName();
+
+		PackageNames.Add(PackageName);
+
+		// unchanged since the last run when the package guid is the same and every section is known
+		bool bUpToDate = Table.GetPackageGuid(PackageName) == Package->GetGuid();
+
+		for (int32 Section = 1; Section <= Montage.Value && bUpToDate; ++Section)
+		{
+			bUpToDate = Table.Find(Montage.Key, AThePunchCharacter::GetAttackSectionName(Section)) != NULL;
+		}
+
+		if (bUpToDate)
+		{
+			++Reused;
+		}
+		else
+		{
+			TMap<FName, FAttackFrameData> Sections;
+
+			for (int32 Section = 1; Section <= Montage.Value; ++Section)
+			{
+				const FName SectionName = AThePunchCharacter::GetAttackSectionName(Section);
+				Sections.Add(SectionName, FAttackFrameData::Analyze(Montage.Key, SectionName, TickRate));
+			}
+
+			Table.SetMontage(PackageName, Package->GetGuid(), Sections);
+
+			++Analyzed;
+		}
+
+		for (int32 Section = 1; Section <= Montage.Value; ++Section)
+		{
+			const FName SectionName = AThePunchCharacter::GetAttackSectionName(Section);
+			const FAttackFrameData* FrameData = Table.Find(Montage.Key, SectionName);
+
+			if (FrameData == NULL)
+			{
+				continue;
+			}
+
+			if (FrameData->Flags != EFrameDataFlags::NONE)
+			{
+				UE_LOG(LogThePunch, Warning, TEXT("%s %s: %s"), *Montage.Key->GetName(), *SectionName.ToString(), *FrameData->GetFlagNames());
+
+				++Flagged;
+			}
+
+			UE_LOG(LogThePunch, Display, TEXT("%s %s: startup %d, active %d, recovery %d frames"), *Montage.Key->GetName(), *SectionName.ToString(),
+				FrameData->Startup, FrameData->Active, FrameData->Recovery);
+		}
+	}
+
+	// montages the data table stopped using
+	Table.RemoveMontagesExcept(PackageNames);
+
+	if (!Table.Save())
+	{
+		UE_LOG(LogThePunch, Error, TEXT("Could not write %s"), *FAttackFrameDataTable::GetPath());
+		return 1;
+	}
+
+	UE_LOG(LogThePunch, Display, TEXT("Frame data at %.0f Hz: %d montages analyzed, %d unchanged, %d sections flagged, written to %s"),
+		TickRate, Analyzed, Reused, Flagged, *FAttackFrameDataTable::GetPath());
+
+	return bStrict && Flagged > 0 ? 1 : 0;
+}
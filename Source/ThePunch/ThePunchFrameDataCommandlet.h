@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ThePunchFrameDataCommandlet.generated.h"
+
+/**
+ * Writes the startup, active and recovery frames of every start_N section of the montages in the
+ * attack data table to Content/FrameData/AttackFrameData.json, see FAttackFrameDataTable.
+ *   UE4Editor-Cmd ThePunch.uproject -run=ThePunchFrameData -TickRate=60
+ * Only montages saved since the last run are analyzed again, -Full analyzes all of them.
+ * Sections with a missing or overlapping window are reported; -Strict fails the run on them.
+ */
+UCLASS()
+class UThePunchFrameDataCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UThePunchFrameDataCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -1,7 +1,14 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "ThePunchGameMode.h"
+#include "ThePunch.h"
 #include "ThePunchCharacter.h"
+#include "ThePunchGameState.h"
+#include "ThePunchArena.h"
+#include "ThePunchPlayerController.h"
+#include "ThePunchSoakDirector.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
 #include "UObject/ConstructorHelpers.h"
 
 AThePunchGameMode::AThePunchGameMode()
@@ -12,4 +19,136 @@ AThePunchGameMode::AThePunchGameMode()
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
+
+	// game state that tracks fighters and their spatial grid
+	GameStateClass = AThePunchGameState::StaticClass();
+
+	// hands the fighter of a player that logs out back to the actor pool
+	PlayerControllerClass = AThePunchPlayerController::StaticClass();
+
+	NumArenas = 0;
+	FightersPerArena = 2;
+	ArenaSpacing = 20000.f;
+}
+
+void AThePunchGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	NumArenas = UGameplayStatics::GetIntOption(Options, TEXT("Arenas"), NumArenas);
+	FightersPerArena = UGameplayStatics::GetIntOption(Options, TEXT("FightersPerArena"), FightersPerArena);
+
+#if !UE_BUILD_SHIPPING
+	// scripted fights for leak hunting, see AThePunchSoakDirector
+	if (AThePunchSoakDirector::IsSoakRequested())
+	{
+		GetWorld()->SpawnActor<AThePunchSoakDirector>(AThePunchSoakDirector::StaticClass(), FVector(0.f, 0.f, 0.f), FRotator::ZeroRotator);
+	}
+#endif
+
+	if (NumArenas <= 0)
+	{
+		return;
+	}
+
+	// lay the arenas out on a square grid around the world origin
+	const int32 Columns = FMath::CeilToInt(FMath::Sqrt(float(NumArenas)));
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 Index = 0; Index < NumArenas; ++Index)
+	{
+		const FVector Location((Index % Columns) * ArenaSpacing, (Index / Columns) * ArenaSpacing, 0.f);
+
+		AThePunchArena* Arena = GetWorld()->SpawnActor<AThePunchArena>(AThePunchArena::StaticClass(), Location, FRotator::ZeroRotator, SpawnParams);
+
+		if (Arena)
+		{
+			Arena->MaxFighters = FightersPerArena;
+			HostedArenas.Add(Arena);
+		}
+	}
+
+	UE_LOG(LogThePunch, Log, TEXT("Hosting %d arenas of %d fighters"), HostedArenas.Num(), FightersPerArena);
+}
+
+APawn* AThePunchGameMode::SpawnDefaultPawnFor_Implementation(AController* NewPlayer, AActor* StartSpot)
+{
+	AThePunchArena* Arena = FindFreeArena();
+
+	if (Arena == NULL)
+	{
+		return Super::SpawnDefaultPawnFor_Implementation(NewPlayer, StartSpot);
+	}
+
+	APawn* Pawn = SpawnDefaultPawnAtTransform(NewPlayer, Arena->GetSpawnTransform());
+	AThePunchCharacter* Fighter = Cast<AThePunchCharacter>(Pawn);
+
+	if (Fighter)
+	{
+		Arena->AddFighter(Fighter);
+	}
+
+	return Pawn;
+}
+
+APawn* AThePunchGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	AThePunchGameState* PunchGameState = GetGameState<AThePunchGameState>();
+	UClass* PawnClass = GetDefaultPawnClassForController(NewPlayer);
+
+	if (PunchGameState == NULL || PunchGameState->GetActorPool().GetNumParked(PawnClass) == 0)
+	{
+		return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+	}
+
+	return PunchGameState->GetActorPool().Acquire<APawn>(GetWorld(), PawnClass, SpawnTransform);
+}
+
+bool AThePunchGameMode::ReleaseFighter(APawn* Pawn)
+{
+	AThePunchGameState* PunchGameState = GetGameState<AThePunchGameState>();
+
+	// the pool only hands out the default pawn class, anything else would never be taken again
+	if (PunchGameState == NULL || Pawn == NULL || Pawn->IsPendingKill() || Pawn->GetClass() != *DefaultPawnClass)
+	{
+		return false;
+	}
+
+	// parking unpossesses the fighter and takes it out of the match and its arena
+	PunchGameState->GetActorPool().Release(Pawn);
+
+	return true;
+}
+
+bool AThePunchGameMode::FighterKilled(AThePunchCharacter* Fighter)
+{
+	AController* FighterController = Fighter ? Fighter->GetController() : NULL;
+
+	if (!ReleaseFighter(Fighter))
+	{
+		return false;
+	}
+
+	// the player comes back on the next parked fighter, see SpawnDefaultPawnAtTransform
+	if (Cast<APlayerController>(FighterController))
+	{
+		RestartPlayer(FighterController);
+	}
+
+	return true;
+}
+
+AThePunchArena* AThePunchGameMode::FindFreeArena() const
+{
+	for (AThePunchArena* Arena : HostedArenas)
+	{
+		if (Arena && Arena->HasFreeSlot())
+		{
+			return Arena;
+		}
+	}
+
+	return NULL;
 }
@@ -6,14 +6,50 @@
 #include "GameFramework/GameModeBase.h"
 #include "ThePunchGameMode.generated.h"
 
-UCLASS(minimalapi)
+class AThePunchArena;
+
+UCLASS(minimalapi, config=Game)
 class AThePunchGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	AThePunchGameMode();
-};
 
+	// reads the host mode options, e.g. "?Arenas=16?FightersPerArena=2"
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	// in host mode, places each new fighter into the first arena with a free slot
+	virtual APawn* SpawnDefaultPawnFor_Implementation(AController* NewPlayer, AActor* StartSpot) override;
+
+	// takes a parked fighter from the game state's actor pool when there is one
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
+	/**
+	* ReleaseFighter - parks a fighter leaving the match in the game state's actor pool
+	* @param Pawn fighter that died or whose player logged out
+	* @return false when the pawn is not of the default pawn class, the caller then destroys it
+	*/
+	bool ReleaseFighter(APawn* Pawn);
 
+	// parks a fighter that fell out of the world and restarts its player; false when it was not parked
+	bool FighterKilled(class AThePunchCharacter* Fighter);
 
+	// number of isolated matches this process hosts; 0 runs a single classic match
+	UPROPERTY(config, EditDefaultsOnly, BlueprintReadOnly, Category = "Host Mode")
+	int32 NumArenas;
+
+	UPROPERTY(config, EditDefaultsOnly, BlueprintReadOnly, Category = "Host Mode")
+	int32 FightersPerArena;
+
+	// distance between arena centers, far enough that fighters and traces never cross
+	UPROPERTY(config, EditDefaultsOnly, BlueprintReadOnly, Category = "Host Mode")
+	float ArenaSpacing;
+
+private:
+	// returns the first arena with room for another fighter, or null
+	AThePunchArena* FindFreeArena() const;
+
+	UPROPERTY(Transient)
+	TArray<AThePunchArena*> HostedArenas;
+};
@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchGameState.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchArena.h"
+#include "ThePunchImpactEffect.h"
+#include "CombatAssetSet.h"
+#include "Async/ParallelFor.h"
+#include "Misc/App.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "EngineUtils.h"
+#include "CombatBenchmarks.h"
+
+DECLARE_CYCLE_STAT(TEXT("Rebuild Fighter Grid"), STAT_RebuildFighterGrid, STATGROUP_ThePunch);
+DECLARE_CYCLE_STAT(TEXT("Update Arenas"), STAT_UpdateArenas, STATGROUP_ThePunch);
+
+AThePunchGameState::AThePunchGameState()
+{
+	// rebuild the grid before characters tick so targeting sees this frame's positions
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bEnableAnimationSharing = true;
+	UniqueAnimationDistance = 1500.f;
+	AnimationSharingTimeStep = 1.f / 15.f;
+	bIsAnimationShared = false;
+	MaxSimulatedHitReactions = 8;
+	bUseAttackScripts = true;
+	PooledFighters = 4;
+	PooledImpactEffects = 16;
+	ImpactEffectClass = NULL;
+	CombatAssets = NULL;
+	NetInterestRadius = 5000.f;
+	AverageArenaPassMs = 0.f;
+	ArenaPassFrames = 0;
+	bArenaPassParallel = false;
+	AverageFrameBusyMs = 0.f;
+	MinFightersForParallelArenas = 64;
+	ArenaTickRate = 30.f;
+}
+
+void AThePunchGameState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	HitReactions.SetMaxSimulatedFighters(MaxSimulatedHitReactions);
+
+	if (FMatchStateExport::IsExportRequested())
+	{
+		MatchStateExport.Open(FMatchStateExport::GetRegionName());
+	}
+
+	// montages and data table of the fighter class stay in one GC cluster until the match ends;
+	// clients have no game mode, the replicated game mode class has the same default pawn
+	const AGameModeBase* GameModeDefaults = GetDefaultGameMode();
+	UClass* FighterClass = GameModeDefaults && GameModeDefaults->DefaultPawnClass ? *GameModeDefaults->DefaultPawnClass : AThePunchCharacter::StaticClass();
+
+	if (const AThePunchCharacter* FighterDefaults = Cast<AThePunchCharacter>(FighterClass->GetDefaultObject()))
+	{
+		CombatAssets = NewObject<UCombatAssetSet>(GetTransientPackage());
+		CombatAssets->Gather(FighterDefaults);
+		CombatAssets->MakeResident();
+	}
+
+	// respawns and hit effects reuse these instead of running the actor constructors mid fight
+	const AGameModeBase* GameMode = GetWorld()->GetAuthGameMode();
+
+	if (GameMode && GameMode->DefaultPawnClass)
+	{
+		ActorPool.Prewarm(GetWorld(), GameMode->DefaultPawnClass, PooledFighters);
+	}
+
+	if (ImpactEffectClass && GetNetMode() != NM_DedicatedServer)
+	{
+		ActorPool.Prewarm(GetWorld(), ImpactEffectClass, PooledImpactEffects);
+	}
+
+	// on clients the game state can replicate after fighters have already begun play
+	for (TActorIterator<AThePunchCharacter> It(GetWorld()); It; ++It)
+	{
+		if (It->HasActorBegunPlay() && !It->IsParked())
+		{
+			RegisterFighter(*It);
+		}
+	}
+}
+
+void AThePunchGameState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	MatchStateExport.Close();
+
+	// parked fighters and effects would otherwise outlive the match in the pool's bookkeeping
+	ActorPool.Empty();
+
+	if (CombatAssets)
+	{
+		CombatAssets->Release();
+		CombatAssets = NULL;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AThePunchGameState::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (Arenas.Num() > 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_UpdateArenas);
+
+		const uint32 StartCycles = FPlatformTime::Cycles();
+
+		// arenas are independent, spread their updates over the task graph workers once there is enough to spread
+		bArenaPassParallel = Fighters.Num() >= MinFightersForParallelArenas;
+
+		ParallelFor(Arenas.Num(), [this, DeltaSeconds](int32 Index)
+		{
+			Arenas[Index]->UpdateCombat(DeltaSeconds);
+		}, !bArenaPassParallel);
+
+		// budgets change actor ticks, only the game thread may do that
+		for (AThePunchArena* Arena : Arenas)
+		{
+			Arena->ApplyBudget();
+		}
+
+		const float PassMs = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles);
+		const float BusyMs = (float)(FMath::Max(0.0, FApp::GetDeltaTime() - FApp::GetIdleTime()) * 1000.0);
+
+		++ArenaPassFrames;
+		AverageArenaPassMs += (PassMs - AverageArenaPassMs) / ArenaPassFrames;
+		AverageFrameBusyMs += (BusyMs - AverageFrameBusyMs) / ArenaPassFrames;
+	}
+
+	// in host mode this is the grid of viewers outside any arena, spectators included
+	RebuildFighterGrid();
+
+	// relevancy is decided on the server, after this frame's grids are built
+	if (GetNetMode() == NM_DedicatedServer || GetNetMode() == NM_ListenServer)
+	{
+		NetInterest.InterestRadius = NetInterestRadius;
+		NetInterest.Update(GetWorld(), Fighters, FighterGrid);
+	}
+
+	HitReactions.Update(GetWorld()->GetTimeSeconds());
+
+	// windows open and close at the montage time the fighters reached last frame
+	AttackScheduler.Update();
+
+	// observers see the fighters as they start the frame, with the hits of the last one
+	if (MatchStateExport.IsOpen())
+	{
+		MatchStateExport.Publish(Fighters, GetWorld()->GetTimeSeconds());
+	}
+
+	// without a local viewer every fighter would count as background, and the server's bones are the ones hits are judged on
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const bool bHasViewer = PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager;
+
+	if (bEnableAnimationSharing && bHasViewer && !IsNetMode(NM_DedicatedServer))
+	{
+		const FVector ViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+
+		AnimSharing.UniqueEvaluationDistance = UniqueAnimationDistance;
+		AnimSharing.TimeStep = AnimationSharingTimeStep;
+		AnimSharing.Update(Fighters, ViewLocation, bHasViewer);
+
+		bIsAnimationShared = true;
+	}
+	else if (bIsAnimationShared)
+	{
+		// sharing was switched off or the viewer left, give every fighter its own pose back
+		AnimSharing.Reset(Fighters);
+
+		bIsAnimationShared = false;
+	}
+}
+
+void AThePunchGameState::PlayImpactEffect(const FVector& Location, const FVector& Normal)
+{
+	if (ImpactEffectClass && GetNetMode() != NM_DedicatedServer)
+	{
+		ActorPool.Acquire(GetWorld(), ImpactEffectClass, FTransform(Normal.Rotation(), Location));
+	}
+}
+
+void AThePunchGameState::RebuildFighterGrid()
+{
+	SCOPE_CYCLE_COUNTER(STAT_RebuildFighterGrid);
+
+	FighterGrid.Rebuild(Fighters);
+}
+
+void AThePunchGameState::RegisterFighter(AThePunchCharacter* Fighter)
+{
+	if (Fighter != NULL)
+	{
+		Fighters.AddUnique(Fighter);
+
+		// both tick in TG_PrePhysics, the grid must be built before the fighter queries it
+		Fighter->AddTickPrerequisiteActor(this);
+	}
+}
+
+void AThePunchGameState::UnregisterFighter(AThePunchCharacter* Fighter)
+{
+	if (Fighter != NULL)
+	{
+		Fighter->RemoveTickPrerequisiteActor(this);
+	}
+
+	Fighters.RemoveSingleSwap(Fighter);
+	HitReactions.Remove(Fighter);
+	AttackScheduler.Stop(Fighter);
+}
+
+void AThePunchGameState::RegisterArena(AThePunchArena* Arena)
+{
+	if (Arena != NULL)
+	{
+		Arenas.AddUnique(Arena);
+	}
+}
+
+void AThePunchGameState::UnregisterArena(AThePunchArena* Arena)
+{
+	Arenas.RemoveSingleSwap(Arena);
+}
+
+#if !UE_BUILD_SHIPPING
+
+// lock-on target selection in a crowd of 500 fighters, with the grid rebuild it depends on
+static FCombatBenchmarkResult BenchmarkTargetSelection(UWorld* World, bool bRebuild)
+{
+	static const int32 Count = 500;
+	static const float Spacing = 200.f;
+
+	AThePunchGameState* GameState = World->GetGameState<AThePunchGameState>();
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* FighterClass = GameMode && GameMode->DefaultPawnClass ? *GameMode->DefaultPawnClass : AThePunchCharacter::StaticClass();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// a square away from the benchmark pair, the selecting fighter stands in its middle
+	const int32 Columns = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(Count)));
+	TArray<AThePunchCharacter*> Crowd;
+	Crowd.Reserve(Count);
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector Location((Index % Columns) * Spacing, -20000.f + (Index / Columns) * Spacing, 200.f);
+		AThePunchCharacter* Fighter = World->SpawnActor<AThePunchCharacter>(FighterClass, FTransform(Location), SpawnParams);
+
+		if (Fighter)
+		{
+			Crowd.Add(Fighter);
+		}
+	}
+
+	const int32 CenterIndex = (Columns / 2) * Columns + Columns / 2;
+	AThePunchCharacter* Selector = Crowd.IsValidIndex(CenterIndex) ? Crowd[CenterIndex] : NULL;
+
+	if (GameState)
+	{
+		GameState->RebuildFighterGrid();
+	}
+
+	FCombatBenchmarkResult Result;
+
+	if (bRebuild)
+	{
+		Result = FCombatBenchmarks::Measure(TEXT("Targeting.GridRebuild500"), 1000, [GameState]()
+		{
+			if (GameState)
+			{
+				GameState->RebuildFighterGrid();
+			}
+		});
+	}
+	else
+	{
+		Result = FCombatBenchmarks::Measure(TEXT("Targeting.FindBestTarget500"), 10000, [Selector]()
+		{
+			if (Selector)
+			{
+				Selector->FindBestTarget();
+			}
+		});
+	}
+
+	for (AThePunchCharacter* Fighter : Crowd)
+	{
+		Fighter->Destroy();
+	}
+
+	// the destroyed crowd left the match, drop it from the grid as well
+	if (GameState)
+	{
+		GameState->RebuildFighterGrid();
+	}
+
+	return Result;
+}
+
+static struct FRegisterTargetSelectionBenchmarks
+{
+	FRegisterTargetSelectionBenchmarks()
+	{
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkTargetSelection(World, true); });
+		FCombatBenchmarks::GetExtraBenchmarks().Add([](UWorld* World) { return BenchmarkTargetSelection(World, false); });
+	}
+} RegisterTargetSelectionBenchmarks;
+
+#endif
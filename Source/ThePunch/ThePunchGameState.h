@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "FighterSpatialGrid.h"
+#include "FighterAnimSharing.h"
+#include "HitReactionPool.h"
+#include "FighterNetInterest.h"
+#include "MatchStateExport.h"
+#include "AttackScript.h"
+#include "ActorPool.h"
+#include "ThePunchGameState.generated.h"
+
+class AThePunchCharacter;
+class AThePunchArena;
+
+/**
+ * Keeps track of every fighter in the match. Once per frame, before any character ticks,
+ * it updates every hosted arena and enforces their budgets, rebuilds the fighter spatial grid of the match and
+ * regroups background fighters that share a pose. Also owns the physics hit reaction budget
+ * and, on servers, the replication interest of every connection.
+ * Exists on the server and on clients.
+ */
+UCLASS(config=Game)
+class THEPUNCH_API AThePunchGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	AThePunchGameState();
+
+	// called when the game begins; picks up fighters that spawned before the game state
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	// adds a fighter to the match, called from AThePunchCharacter::BeginPlay
+	void RegisterFighter(AThePunchCharacter* Fighter);
+
+	// removes a fighter from the match, called from AThePunchCharacter::EndPlay
+	void UnregisterFighter(AThePunchCharacter* Fighter);
+
+	// adds an arena hosted by this process, called from AThePunchArena::BeginPlay
+	void RegisterArena(AThePunchArena* Arena);
+
+	void UnregisterArena(AThePunchArena* Arena);
+
+	/** returns every arena hosted by this process, empty outside of host mode **/
+	const TArray<AThePunchArena*>& GetArenas() const { return Arenas; }
+
+	/** returns the average wall time of the arena update, in milliseconds **/
+	float GetAverageArenaPassMs() const { return AverageArenaPassMs; }
+
+	/** true when the last arena update was spread over the workers **/
+	bool IsArenaPassParallel() const { return bArenaPassParallel; }
+
+	/** returns the average game thread time of a frame without its idle wait, in milliseconds **/
+	float GetAverageFrameBusyMs() const { return AverageFrameBusyMs; }
+
+	/** returns all fighters registered in the match **/
+	const TArray<AThePunchCharacter*>& GetFighters() const { return Fighters; }
+
+	/** returns the spatial grid built from fighter locations at the start of this frame **/
+	const FFighterSpatialGrid& GetFighterGrid() const { return FighterGrid; }
+
+	// buckets the registered fighters again, done every tick
+	void RebuildFighterGrid();
+
+	/** returns the physics slots hit reactions are granted from **/
+	FHitReactionPool& GetHitReactions() { return HitReactions; }
+
+	/** returns the fighters each connection is interested in, only updated on servers **/
+	const FFighterNetInterest& GetNetInterest() const { return NetInterest; }
+
+	/** returns the scheduler that runs the attack scripts of every fighter **/
+	FAttackScheduler& GetAttackScheduler() { return AttackScheduler; }
+
+	/** returns the pool fighters and impact effects are taken from instead of spawned **/
+	FActorPool& GetActorPool() { return ActorPool; }
+
+	// plays ImpactEffectClass from the pool where a hit landed, nothing on a dedicated server
+	void PlayImpactEffect(const FVector& Location, const FVector& Normal);
+
+	/** returns the shared memory export for local observers, open only with -MatchStateExport **/
+	FMatchStateExport& GetMatchStateExport() { return MatchStateExport; }
+
+	/** returns the combat assets kept resident for the match, null before BeginPlay **/
+	class UCombatAssetSet* GetCombatAssets() const { return CombatAssets; }
+
+	// fighters further than this from a connection's view target are not replicated to it
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Replication)
+	float NetInterestRadius;
+
+	// fighters of the default pawn class spawned and parked when the match starts, on the server
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Pooling)
+	int32 PooledFighters;
+
+	// impact effects spawned and parked when the match starts, on every process that renders
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Pooling)
+	int32 PooledImpactEffects;
+
+	// played where attacks and traces connect; none when not set
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Pooling)
+	TSubclassOf<class AThePunchImpactEffect> ImpactEffectClass;
+
+	// attacks follow scripts resumed from montage time instead of notify callbacks
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat)
+	bool bUseAttackScripts;
+
+	// fighters that may simulate a hit reaction at the same time, the rest play canned reactions
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Physics)
+	int32 MaxSimulatedHitReactions;
+
+	// background fighters doing the same thing share one evaluated pose; never on a dedicated server,
+	// and only when a local player views the match. Turn it off in DefaultGame.ini under [/Script/ThePunch.ThePunchGameState]
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = Animation)
+	bool bEnableAnimationSharing;
+
+	// hosted fighters below which the arenas update on the game thread, a worker pass costs more than it saves
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Arena)
+	int32 MinFightersForParallelArenas;
+
+	// frames per second a host is meant to run at, matches per core are counted against it
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Arena)
+	float ArenaTickRate;
+
+	// fighters closer than this to the camera always evaluate their own pose
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation)
+	float UniqueAnimationDistance;
+
+	// fighters whose montage time falls within the same step share a pose
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Animation)
+	float AnimationSharingTimeStep;
+
+private:
+	UPROPERTY(Transient)
+	TArray<AThePunchCharacter*> Fighters;
+
+	UPROPERTY(Transient)
+	TArray<AThePunchArena*> Arenas;
+
+	UPROPERTY(Transient)
+	class UCombatAssetSet* CombatAssets;
+
+	FFighterSpatialGrid FighterGrid;
+
+	FFighterAnimSharing AnimSharing;
+
+	FHitReactionPool HitReactions;
+
+	FFighterNetInterest NetInterest;
+
+	FMatchStateExport MatchStateExport;
+
+	FAttackScheduler AttackScheduler;
+
+	FActorPool ActorPool;
+
+	// true while some fighters follow a shared pose
+	bool bIsAnimationShared;
+
+	// running average of the arena update and the frames it covers
+	float AverageArenaPassMs;
+
+	int32 ArenaPassFrames;
+
+	bool bArenaPassParallel;
+
+	// running average of the game thread's busy time per frame, over ArenaPassFrames
+	float AverageFrameBusyMs;
+};
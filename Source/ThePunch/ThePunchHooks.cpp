@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchHooks.h"
+#include "ThePunch.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/CommandLine.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Parse.h"
+#include "Modules/ModuleManager.h"
+
+FThePunchHooks::FOnFighterBeginPlay FThePunchHooks::OnFighterBeginPlay;
+FThePunchHooks::FOnSetupFighterInput FThePunchHooks::OnSetupFighterInput;
+FThePunchHooks::FOnAttackThrown FThePunchHooks::OnAttackThrown;
+FThePunchHooks::FOnAttackHit FThePunchHooks::OnAttackHit;
+FThePunchHooks::FOnCombatStateReset FThePunchHooks::OnCombatStateReset;
+FThePunchHooks::FOnLineTraceFinished FThePunchHooks::OnLineTraceFinished;
+
+/** startup cost of one module */
+struct FModuleStartup
+{
+	FName ModuleName;
+
+	double Seconds;
+
+	// change of used physical memory while the module loaded, can be negative
+	int64 ResidentBytes;
+};
+
+static TArray<FModuleStartup>& GetModuleStartups()
+{
+	static TArray<FModuleStartup> Startups;
+	return Startups;
+}
+
+// server, commandlet, editor or client, the configurations the startup numbers are compared across
+static const TCHAR* GetProcessConfiguration()
+{
+	if (IsRunningCommandlet())
+	{
+		return TEXT("commandlet");
+	}
+
+	if (IsRunningDedicatedServer())
+	{
+		return TEXT("server");
+	}
+
+	return GIsEditor ? TEXT("editor") : TEXT("client");
+}
+
+void FThePunchHooks::LoadOptionalModules()
+{
+	// nothing of VR, audio or debug drawing is seen by a server or a headless tool
+	if (IsRunningDedicatedServer() || IsRunningCommandlet())
+	{
+		return;
+	}
+
+	TArray<FString> ModuleNames;
+	FString CommandLineModules;
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("PunchModules="), CommandLineModules))
+	{
+		CommandLineModules.ParseIntoArray(ModuleNames, TEXT("+"));
+	}
+	else if (GConfig)
+	{
+		GConfig->GetArray(TEXT("ThePunch.Modules"), TEXT("OptionalModules"), ModuleNames, GGameIni);
+	}
+
+	FModuleManager& ModuleManager = FModuleManager::Get();
+
+	for (const FString& ModuleName : ModuleNames)
+	{
+		const FName Name(*ModuleName);
+
+		// not built for this target, e.g. the server target blacklists every optional module
+		if (ModuleManager.IsModuleLoaded(Name) || !ModuleManager.ModuleExists(*ModuleName))
+		{
+			continue;
+		}
+
+		const uint64 ResidentBytesBefore = FPlatformMemory::GetStats().UsedPhysical;
+		const double StartSeconds = FPlatformTime::Seconds();
+
+		if (ModuleManager.LoadModule(Name))
+		{
+			RecordModuleStartup(Name, FPlatformTime::Seconds() - StartSeconds, ResidentBytesBefore);
+		}
+		else
+		{
+			UE_LOG(LogThePunch, Warning, TEXT("Optional module %s failed to load"), *ModuleName);
+		}
+	}
+}
+
+void FThePunchHooks::RecordModuleStartup(FName ModuleName, double Seconds, uint64 ResidentBytesBefore)
+{
+	FModuleStartup Startup;
+	Startup.ModuleName = ModuleName;
+	Startup.Seconds = Seconds;
+	Startup.ResidentBytes = (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)ResidentBytesBefore;
+
+	GetModuleStartups().Add(Startup);
+}
+
+void FThePunchHooks::LogModules()
+{
+	double TotalSeconds = 0.0;
+	int64 TotalBytes = 0;
+
+	for (const FModuleStartup& Startup : GetModuleStartups())
+	{
+		UE_LOG(LogThePunch, Display, TEXT("%-14s %7.2f ms  %+8.2f MB resident"), *Startup.ModuleName.ToString(), Startup.Seconds * 1000.0, Startup.ResidentBytes / (1024.0 * 1024.0));
+
+		TotalSeconds += Startup.Seconds;
+		TotalBytes += Startup.ResidentBytes;
+	}
+
+	UE_LOG(LogThePunch, Display, TEXT("ThePunch modules (%s): %d up %.2f ms after process start, %+.2f MB resident, %.2f MB used by the process"), GetProcessConfiguration(),
+		GetModuleStartups().Num(), TotalSeconds * 1000.0, TotalBytes / (1024.0 * 1024.0), FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0));
+}
+
+static FAutoConsoleCommand LogModulesCommand(
+	TEXT("ThePunch.Modules"),
+	TEXT("Prints the load time and resident memory of the core and the optional ThePunch modules"),
+	FConsoleCommandDelegate::CreateStatic(&FThePunchHooks::LogModules));
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Delegates/Delegate.h"
+
+class AThePunchCharacter;
+class UInputComponent;
+struct FHitResult;
+
+/**
+ * Extension points of the combat runtime. The optional modules bind to these so the core module
+ * never links HMD, audio or debug drawing code:
+ *   ThePunchVR    - VR reset and touch input
+ *   ThePunchAudio - punch and throw sounds
+ *   ThePunchDebug - line trace visualization
+ * Which of them load is set by [ThePunch.Modules] in DefaultGame.ini, or -PunchModules=A+B on
+ * the command line. Dedicated servers and commandlets load none of them.
+ */
+class THEPUNCH_API FThePunchHooks
+{
+public:
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnFighterBeginPlay, AThePunchCharacter*);
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnSetupFighterInput, AThePunchCharacter*, UInputComponent*);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnAttackThrown, AThePunchCharacter*);
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FOnAttackHit, AThePunchCharacter*, uint64);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnCombatStateReset, AThePunchCharacter*);
+	DECLARE_MULTICAST_DELEGATE_FourParams(FOnLineTraceFinished, const AThePunchCharacter*, const FVector&, const FVector&, const FHitResult*);
+
+	// broadcast from AThePunchCharacter::BeginPlay, once per fighter even when it is pooled
+	static FOnFighterBeginPlay OnFighterBeginPlay;
+
+	// broadcast at the end of AThePunchCharacter::SetupPlayerInputComponent
+	static FOnSetupFighterInput OnSetupFighterInput;
+
+	// broadcast when an attack swings, from the throw notifies or the attack script
+	static FOnAttackThrown OnAttackThrown;
+
+	// broadcast when an attack connects, with the FPlatformTime::Cycles64 of the hit callback
+	static FOnAttackHit OnAttackHit;
+
+	// broadcast when a fighter is reset for reuse, see AThePunchCharacter::ResetCombatState
+	static FOnCombatStateReset OnCombatStateReset;
+
+	// broadcast after FireLineTrace, the hit is null when the trace found nothing
+	static FOnLineTraceFinished OnLineTraceFinished;
+
+	// loads the optional modules enabled for this process, called once by the core module
+	static void LoadOptionalModules();
+
+	/**
+	* RecordModuleStartup - remembers how long a module took to start and the memory it added
+	* @param ModuleName name of the module
+	* @param Seconds time spent loading and starting the module; for ThePunch itself, the time since process start
+	* @param ResidentBytesBefore used physical memory before the module was loaded, 0 for ThePunch
+	*/
+	static void RecordModuleStartup(FName ModuleName, double Seconds, uint64 ResidentBytesBefore);
+
+	// logs load time and resident memory of every module started so far, the totals are from process start
+	static void LogModules();
+};
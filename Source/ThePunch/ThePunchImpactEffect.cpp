@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchImpactEffect.h"
+#include "ThePunchGameState.h"
+#include "Engine/World.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "TimerManager.h"
+
+AThePunchImpactEffect::AThePunchImpactEffect()
+{
+	Particles = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("Particles"));
+	Particles->bAutoActivate = false;
+	RootComponent = Particles;
+
+	// purely cosmetic, every process plays its own
+	bReplicates = false;
+	SetActorEnableCollision(false);
+
+	Lifetime = 1.f;
+}
+
+void AThePunchImpactEffect::Play()
+{
+	// collision stays off, the effect never blocks anything
+	SetActorEnableCollision(false);
+
+	Particles->ActivateSystem(true);
+
+	GetWorldTimerManager().SetTimer(LifetimeTimer, this, &AThePunchImpactEffect::ReturnToPool, Lifetime, false);
+}
+
+void AThePunchImpactEffect::Stop()
+{
+	Particles->DeactivateSystem();
+
+	GetWorldTimerManager().ClearTimer(LifetimeTimer);
+}
+
+void AThePunchImpactEffect::ReturnToPool()
+{
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	if (GameState)
+	{
+		GameState->GetActorPool().Release(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
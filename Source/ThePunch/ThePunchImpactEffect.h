@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ThePunchImpactEffect.generated.h"
+
+/**
+ * Particles played where an attack or a trace connects. Taken from the game state's actor pool
+ * with AThePunchGameState::PlayImpactEffect and parked again once Lifetime has passed.
+ */
+UCLASS()
+class THEPUNCH_API AThePunchImpactEffect : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AThePunchImpactEffect();
+
+	// restarts the particles, called by the pool when the effect is taken
+	void Play();
+
+	// stops the particles, called by the pool when the effect is parked
+	void Stop();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Effect)
+	class UParticleSystemComponent* Particles;
+
+	// seconds the effect plays before it goes back to the pool
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Effect)
+	float Lifetime;
+
+private:
+	void ReturnToPool();
+
+	FTimerHandle LifetimeTimer;
+};
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchMatchStateCommandlet.h"
+#include "ThePunch.h"
+#include "MatchStateExport.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+UThePunchMatchStateCommandlet::UThePunchMatchStateCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UThePunchMatchStateCommandlet::Main(const FString& Params)
+{
+	FString Name = FMatchStateExport::GetRegionName();
+	float Seconds = 10.f;
+	float WaitSeconds = 30.f;
+
+	FParse::Value(*Params, TEXT("Region="), Name);
+	FParse::Value(*Params, TEXT("Seconds="), Seconds);
+	FParse::Value(*Params, TEXT("Wait="), WaitSeconds);
+
+	FMatchStateReader Reader;
+
+	// the game may still be starting, wait for it to create the region
+	const double WaitEndTime = FPlatformTime::Seconds() + WaitSeconds;
+
+	while (!Reader.Open(Name))
+	{
+		if (FPlatformTime::Seconds() > WaitEndTime)
+		{
+			UE_LOG(LogThePunch, Error, TEXT("No match state region %s after %.0f seconds"), *Name, WaitSeconds);
+			return 1;
+		}
+
+		FPlatformProcess::Sleep(0.1f);
+	}
+
+	return Reader.Verify(Seconds) ? 0 : 1;
+}
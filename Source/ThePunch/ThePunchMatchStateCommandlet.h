@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ThePunchMatchStateCommandlet.generated.h"
+
+/**
+ * Observer process for the match state region, checks every snapshot another process publishes.
+ *   UE4Editor-Cmd ThePunch.uproject -run=ThePunchMatchState -Region=ThePunchMatchState -Seconds=10
+ * Returns 0 when frames were read and every one was consistent. ThePunch.MatchState.ReaderProcess
+ * starts it next to a game that publishes.
+ */
+UCLASS()
+class UThePunchMatchStateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UThePunchMatchStateCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
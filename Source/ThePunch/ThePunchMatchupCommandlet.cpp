@@ -0,0 +1,556 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchMatchupCommandlet.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchGameMode.h"
+#include "AttackScript.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "Async/ParallelFor.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/DataTable.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace MatchupSim
+{
+	// one start_N section of a data table row
+	struct FAttack
+	{
+		FName Row;
+
+		int32 Section;
+
+		EAttackType AttackType;
+
+		// seconds from the section start until the hitboxes go live
+		float Startup;
+
+		float Active;
+
+		// the whole section, recovery is what follows the window
+		float Duration;
+
+		// how far in front of the attacker's origin the hitboxes get
+		float Reach;
+	};
+
+	struct FBot
+	{
+		FString Name;
+
+		// indices into the attack list the bot picks from
+		TArray<int32> Attacks;
+	};
+
+	struct FRules
+	{
+		float StepTime;
+
+		float MaxMatchTime;
+
+		int32 HitsToWin;
+
+		float StartDistance;
+
+		float CapsuleRadius;
+
+		float WalkSpeed;
+
+		float LightHitStun;
+
+		float KnockdownStun;
+	};
+
+	struct FFighter
+	{
+		float Position;
+
+		// +1 when the opponent is toward +X
+		float Facing;
+
+		// attack being played, INDEX_NONE when idle
+		int32 Attack;
+
+		float AttackTime;
+
+		bool bConnected;
+
+		// attack the bot walks in for
+		int32 PlannedAttack;
+
+		float StunTime;
+
+		float RetreatTime;
+
+		float NextDecisionTime;
+
+		int32 Hits;
+	};
+
+	// per attack totals of one match, a slice of the sweep's flat arrays
+	struct FMatchStats
+	{
+		int32* Attacks;
+
+		int32* Hits;
+
+		float* TimeToHit;
+	};
+
+	/**
+	* Simulate - one match of two bots on a line, fixed time steps
+	* @return index of the winning bot side, INDEX_NONE for a draw
+	*/
+	static int32 Simulate(const FRules& Rules, const TArray<FAttack>& Attacks, const FBot& Bot0, const FBot& Bot1, int32 Seed, FMatchStats& Stats, float& OutDuration)
+	{
+		FRandomStream Random(Seed);
+
+		const FBot* Bots[2] = { &Bot0, &Bot1 };
+		FFighter Fighters[2];
+
+		for (int32 Side = 0; Side < 2; ++Side)
+		{
+			FFighter& Fighter = Fighters[Side];
+			Fighter.Facing = Side == 0 ? 1.f : -1.f;
+			Fighter.Position = -Fighter.Facing * Rules.StartDistance * 0.5f;
+			Fighter.Attack = INDEX_NONE;
+			Fighter.AttackTime = 0.f;
+			Fighter.bConnected = false;
+			Fighter.PlannedAttack = INDEX_NONE;
+			Fighter.StunTime = 0.f;
+			Fighter.RetreatTime = 0.f;
+			Fighter.NextDecisionTime = Random.FRandRange(0.f, 0.3f);
+			Fighter.Hits = 0;
+		}
+
+		float Time = 0.f;
+
+		while (Time < Rules.MaxMatchTime && Fighters[0].Hits < Rules.HitsToWin && Fighters[1].Hits < Rules.HitsToWin)
+		{
+			const float Distance = FMath::Abs(Fighters[1].Position - Fighters[0].Position);
+
+			// hits land for both sides at once, the first side gets no advantage
+			int32 HitAttacks[2] = { INDEX_NONE, INDEX_NONE };
+			float HitTimes[2] = { 0.f, 0.f };
+
+			for (int32 Side = 0; Side < 2; ++Side)
+			{
+				FFighter& Self = Fighters[Side];
+
+				if (Self.StunTime > 0.f)
+				{
+					Self.StunTime -= Rules.StepTime;
+					continue;
+				}
+
+				if (Self.Attack != INDEX_NONE)
+				{
+					const FAttack& Attack = Attacks[Self.Attack];
+
+					Self.AttackTime += Rules.StepTime;
+
+					const bool bWindowOpen = Self.AttackTime >= Attack.Startup && Self.AttackTime <= Attack.Startup + Attack.Active;
+
+					if (!Self.bConnected && bWindowOpen && Distance <= Attack.Reach + Rules.CapsuleRadius)
+					{
+						Self.bConnected = true;
+						HitAttacks[Side] = Self.Attack;
+						HitTimes[Side] = Self.AttackTime;
+					}
+
+					if (Self.AttackTime >= Attack.Duration)
+					{
+						Self.Attack = INDEX_NONE;
+					}
+
+					continue;
+				}
+
+				if (Self.RetreatTime > 0.f)
+				{
+					Self.RetreatTime -= Rules.StepTime;
+					Self.Position -= Self.Facing * Rules.WalkSpeed * Rules.StepTime;
+					continue;
+				}
+
+				// still reacting to what happened last
+				if (Time < Self.NextDecisionTime)
+				{
+					continue;
+				}
+
+				const FBot& Bot = *Bots[Side];
+
+				if (Self.PlannedAttack == INDEX_NONE)
+				{
+					Self.PlannedAttack = Bot.Attacks[Random.RandHelper(Bot.Attacks.Num())];
+				}
+
+				const FAttack& Planned = Attacks[Self.PlannedAttack];
+
+				if (Distance <= Planned.Reach + Rules.CapsuleRadius)
+				{
+					// a quarter of the time the bot backs off instead, so spacing and reach matter
+					if (Random.FRand() < 0.25f)
+					{
+						Self.RetreatTime = Random.FRandRange(0.2f, 0.5f);
+					}
+					else
+					{
+						Self.Attack = Self.PlannedAttack;
+						Self.AttackTime = 0.f;
+						Self.bConnected = false;
+						Self.PlannedAttack = INDEX_NONE;
+
+						++Stats.Attacks[Self.Attack];
+					}
+
+					Self.NextDecisionTime = Time + Random.FRandRange(0.15f, 0.35f);
+				}
+				else
+				{
+					// walk in, never through the opponent
+					const float Room = FMath::Max(Distance - 2.f * Rules.CapsuleRadius, 0.f);
+
+					Self.Position += Self.Facing * FMath::Min(Rules.WalkSpeed * Rules.StepTime, Room);
+				}
+			}
+
+			for (int32 Side = 0; Side < 2; ++Side)
+			{
+				if (HitAttacks[Side] == INDEX_NONE)
+				{
+					continue;
+				}
+
+				FFighter& Victim = Fighters[1 - Side];
+				const FAttack& Attack = Attacks[HitAttacks[Side]];
+
+				// a hit cancels whatever the victim was doing
+				Victim.Attack = INDEX_NONE;
+				Victim.PlannedAttack = INDEX_NONE;
+				Victim.RetreatTime = 0.f;
+				Victim.StunTime = Attack.AttackType == EAttackType::MELEE_KICK ? Rules.KnockdownStun : Rules.LightHitStun;
+
+				++Fighters[Side].Hits;
+				++Stats.Hits[HitAttacks[Side]];
+				Stats.TimeToHit[HitAttacks[Side]] += HitTimes[Side];
+			}
+
+			Time += Rules.StepTime;
+		}
+
+		OutDuration = Time;
+
+		if (Fighters[0].Hits == Fighters[1].Hits)
+		{
+			return INDEX_NONE;
+		}
+
+		return Fighters[0].Hits > Fighters[1].Hits ? 0 : 1;
+	}
+
+	// forward distance of a mesh socket from the actor origin at a montage time, read from the raw animation
+	static float ComputeSocketReach(const USkeletalMesh* Mesh, const FTransform& MeshTransform, const UAnimMontage* Montage, float Time, FName SocketName)
+	{
+		const USkeletalMeshSocket* Socket = Mesh->FindSocket(SocketName);
+
+		if (Socket == NULL || Montage->SlotAnimTracks.Num() == 0)
+		{
+			return 0.f;
+		}
+
+		const FAnimTrack& Track = Montage->SlotAnimTracks[0].AnimTrack;
+		const int32 SegmentIndex = Track.GetSegmentIndexAtTime(Time);
+		const FAnimSegment* Segment = Track.AnimSegments.IsValidIndex(SegmentIndex) ? &Track.AnimSegments[SegmentIndex] : NULL;
+		const UAnimSequence* Sequence = Segment ? Cast<UAnimSequence>(Segment->AnimReference) : NULL;
+		const float SequenceTime = Segment ? Segment->ConvertTrackPosToAnimPos(Time) : 0.f;
+
+		const FReferenceSkeleton& RefSkeleton = Mesh->RefSkeleton;
+		const USkeleton* Skeleton = Mesh->Skeleton;
+
+		// socket to component space, bone by bone up to the root
+		FTransform Transform = Socket->GetSocketLocalTransform();
+
+		for (int32 BoneIndex = RefSkeleton.FindBoneIndex(Socket->BoneName); BoneIndex != INDEX_NONE; BoneIndex = RefSkeleton.GetParentIndex(BoneIndex))
+		{
+			FTransform Local = RefSkeleton.GetRefBonePose()[BoneIndex];
+
+			if (Sequence && Skeleton)
+			{
+				const int32 SkeletonBoneIndex = Skeleton->GetSkeletonBoneIndexFromMeshBoneIndex(Mesh, BoneIndex);
+				const int32 TrackIndex = Skeleton->GetAnimationTrackIndex(SkeletonBoneIndex, Sequence, true);
+
+				if (TrackIndex != INDEX_NONE)
+				{
+					Sequence->GetBoneTransform(Local, TrackIndex, SequenceTime, true);
+				}
+			}
+
+			Transform = Transform * Local;
+		}
+
+		return (Transform * MeshTransform).GetLocation().X;
+	}
+
+	// reads every start_N section of the rows the fighter attacks with; sections without an attack window are skipped
+	static void GatherAttacks(const AThePunchCharacter* Fighter, TArray<FAttack>& OutAttacks, TArray<FBot>& OutBots)
+	{
+		const UDataTable* Table = Fighter->GetPlayerAttackDataTable();
+		const USkeletalMeshComponent* MeshComponent = Fighter->GetMesh();
+		const USkeletalMesh* Mesh = MeshComponent ? MeshComponent->SkeletalMesh : NULL;
+		const FTransform MeshTransform = MeshComponent ? MeshComponent->GetRelativeTransform() : FTransform::Identity;
+		const float HitboxExtent = Fighter->GetRightMeleeCollisionBox() ? Fighter->GetRightMeleeCollisionBox()->GetScaledBoxExtent().GetMax() : 0.f;
+
+		static const FString ContextString(TEXT("Matchup Commandlet"));
+
+		FBot Mixed;
+		Mixed.Name = TEXT("Mixed");
+
+		// the rows FindAttackMontage plays, other rows are never attacked with
+		const EAttackType AttackTypes[] = { EAttackType::MELEE_FIST, EAttackType::MELEE_KICK };
+
+		for (const EAttackType AttackType : AttackTypes)
+		{
+			const FName Row = AThePunchCharacter::GetAttackRowKey(AttackType);
+			const FPlayerAttackMontage* AttackMontage = Table->FindRow<FPlayerAttackMontage>(Row, ContextString, false);
+
+			if (AttackMontage == NULL || AttackMontage->Montage == NULL)
+			{
+				UE_LOG(LogThePunch, Warning, TEXT("%s has no %s row with a montage, left out of the sweep"), *Table->GetName(), *Row.ToString());
+				continue;
+			}
+
+			FName LeftSocket;
+			FName RightSocket;
+			AThePunchCharacter::GetAttackSocketNames(AttackType, LeftSocket, RightSocket);
+
+			FBot Specialist;
+			Specialist.Name = Row.ToString();
+
+			for (int32 Section = 1; Section <= AttackMontage->AnimSectionCount; ++Section)
+			{
+				const FName SectionName = AThePunchCharacter::GetAttackSectionName(Section);
+				const FAttackTimeline Timeline = FAttackTimeline::Build(AttackMontage->Montage, SectionName);
+
+				if (!Timeline.HasWindow())
+				{
+					UE_LOG(LogThePunch, Warning, TEXT("%s %s has no attack window, left out of the sweep"), *Row.ToString(), *SectionName.ToString());
+					continue;
+				}
+
+				FAttack Attack;
+				Attack.Row = Row;
+				Attack.Section = Section;
+				Attack.AttackType = AttackType;
+				Attack.Startup = Timeline.WindowStart - Timeline.SectionStart;
+				Attack.Active = Timeline.WindowEnd - Timeline.WindowStart;
+				Attack.Duration = Timeline.SectionEnd - Timeline.SectionStart;
+				Attack.Reach = 0.f;
+
+				// the furthest either hitbox gets over the window
+				for (int32 Sample = 0; Sample <= 4 && Mesh; ++Sample)
+				{
+					const float Time = FMath::Lerp(Timeline.WindowStart, Timeline.WindowEnd, Sample / 4.f);
+
+					Attack.Reach = FMath::Max(Attack.Reach, ComputeSocketReach(Mesh, MeshTransform, AttackMontage->Montage, Time, LeftSocket));
+					Attack.Reach = FMath::Max(Attack.Reach, ComputeSocketReach(Mesh, MeshTransform, AttackMontage->Montage, Time, RightSocket));
+				}
+
+				Attack.Reach += HitboxExtent;
+
+				Specialist.Attacks.Add(OutAttacks.Num());
+				Mixed.Attacks.Add(OutAttacks.Num());
+				OutAttacks.Add(Attack);
+			}
+
+			if (Specialist.Attacks.Num() > 0)
+			{
+				OutBots.Add(Specialist);
+			}
+		}
+
+		if (OutBots.Num() > 1)
+		{
+			OutBots.Add(Mixed);
+		}
+	}
+}
+
+UThePunchMatchupCommandlet::UThePunchMatchupCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UThePunchMatchupCommandlet::Main(const FString& Params)
+{
+	using namespace MatchupSim;
+
+	int32 NumMatches = 10000;
+	int32 Seed = 1;
+
+	FRules Rules;
+	Rules.StepTime = 1.f / 60.f;
+	Rules.MaxMatchTime = 90.f;
+	Rules.HitsToWin = 5;
+	Rules.StartDistance = 600.f;
+
+	FParse::Value(*Params, TEXT("Matches="), NumMatches);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("HitsToWin="), Rules.HitsToWin);
+	FParse::Value(*Params, TEXT("MaxMatchSeconds="), Rules.MaxMatchTime);
+	FParse::Value(*Params, TEXT("StartDistance="), Rules.StartDistance);
+
+	// the blueprint fighter may override the montages, the data table and the hitboxes
+	const TSubclassOf<APawn> PawnClass = GetDefault<AThePunchGameMode>()->DefaultPawnClass;
+	UClass* FighterClass = PawnClass && PawnClass->IsChildOf(AThePunchCharacter::StaticClass()) ? *PawnClass : AThePunchCharacter::StaticClass();
+	const AThePunchCharacter* Fighter = FighterClass->GetDefaultObject<AThePunchCharacter>();
+
+	if (Fighter->GetPlayerAttackDataTable() == NULL)
+	{
+		UE_LOG(LogThePunch, Error, TEXT("%s has no attack data table"), *FighterClass->GetName());
+		return 1;
+	}
+
+	Rules.CapsuleRadius = Fighter->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	Rules.WalkSpeed = Fighter->GetCharacterMovement()->MaxWalkSpeed;
+	Rules.LightHitStun = Fighter->LightHitReactionTime;
+	Rules.KnockdownStun = Fighter->KnockdownTime;
+
+	TArray<FAttack> Attacks;
+	TArray<FBot> Bots;
+
+	GatherAttacks(Fighter, Attacks, Bots);
+
+	if (Attacks.Num() == 0)
+	{
+		UE_LOG(LogThePunch, Error, TEXT("No attack section has an attack window, nothing to simulate"));
+		return 1;
+	}
+
+	for (const FAttack& Attack : Attacks)
+	{
+		UE_LOG(LogThePunch, Display, TEXT("%s start_%d: startup %.0f ms, active %.0f ms, recovery %.0f ms, reach %.0f cm"), *Attack.Row.ToString(), Attack.Section,
+			Attack.Startup * 1000.f, Attack.Active * 1000.f, (Attack.Duration - Attack.Startup - Attack.Active) * 1000.f, Attack.Reach);
+	}
+
+	// every bot against every bot, mirror matches included
+	TArray<TPair<int32, int32>> Matchups;
+
+	for (int32 First = 0; First < Bots.Num(); ++First)
+	{
+		for (int32 Second = First; Second < Bots.Num(); ++Second)
+		{
+			Matchups.Add(TPair<int32, int32>(First, Second));
+		}
+	}
+
+	NumMatches = FMath::Max(NumMatches, Matchups.Num());
+
+	const int32 NumAttacks = Attacks.Num();
+
+	// flat per match results, written without locks and summed up afterwards
+	TArray<int32> Winners;
+	TArray<float> Durations;
+	TArray<int32> AttackCounts;
+	TArray<int32> HitCounts;
+	TArray<float> TimesToHit;
+
+	Winners.SetNumUninitialized(NumMatches);
+	Durations.SetNumUninitialized(NumMatches);
+	AttackCounts.SetNumZeroed(NumMatches * NumAttacks);
+	HitCounts.SetNumZeroed(NumMatches * NumAttacks);
+	TimesToHit.SetNumZeroed(NumMatches * NumAttacks);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	ParallelFor(NumMatches, [&](int32 Match)
+	{
+		const TPair<int32, int32>& Matchup = Matchups[Match % Matchups.Num()];
+
+		FMatchStats Stats;
+		Stats.Attacks = &AttackCounts[Match * NumAttacks];
+		Stats.Hits = &HitCounts[Match * NumAttacks];
+		Stats.TimeToHit = &TimesToHit[Match * NumAttacks];
+
+		Winners[Match] = Simulate(Rules, Attacks, Bots[Matchup.Key], Bots[Matchup.Value], Seed + Match, Stats, Durations[Match]);
+	});
+
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+	FString Report = FString::Printf(TEXT("Matches,%d,Seed,%d,HitsToWin,%d,MaxMatchSeconds,%.0f,Seconds,%.2f") LINE_TERMINATOR LINE_TERMINATOR, NumMatches, Seed, Rules.HitsToWin, Rules.MaxMatchTime, Seconds);
+
+	Report += TEXT("Bot,Opponent,Matches,Wins,Losses,Draws,WinRate,AvgMatchSeconds") LINE_TERMINATOR;
+
+	for (int32 MatchupIndex = 0; MatchupIndex < Matchups.Num(); ++MatchupIndex)
+	{
+		int32 Played = 0;
+		int32 Wins[2] = { 0, 0 };
+		double TotalDuration = 0.0;
+
+		for (int32 Match = MatchupIndex; Match < NumMatches; Match += Matchups.Num())
+		{
+			++Played;
+			TotalDuration += Durations[Match];
+
+			if (Winners[Match] != INDEX_NONE)
+			{
+				++Wins[Winners[Match]];
+			}
+		}
+
+		const FString& Bot = Bots[Matchups[MatchupIndex].Key].Name;
+		const FString& Opponent = Bots[Matchups[MatchupIndex].Value].Name;
+		const float WinRate = Played > 0 ? float(Wins[0]) / Played : 0.f;
+
+		Report += FString::Printf(TEXT("%s,%s,%d,%d,%d,%d,%.3f,%.1f") LINE_TERMINATOR, *Bot, *Opponent, Played, Wins[0], Wins[1], Played - Wins[0] - Wins[1], WinRate, Played > 0 ? TotalDuration / Played : 0.0);
+
+		UE_LOG(LogThePunch, Display, TEXT("%s vs %s: %.1f%% wins, %d draws of %d"), *Bot, *Opponent, WinRate * 100.f, Played - Wins[0] - Wins[1], Played);
+	}
+
+	Report += LINE_TERMINATOR TEXT("Row,Section,StartupMs,ActiveMs,RecoveryMs,Reach,Attacks,Hits,HitRate,AvgTimeToHitMs") LINE_TERMINATOR;
+
+	for (int32 AttackIndex = 0; AttackIndex < NumAttacks; ++AttackIndex)
+	{
+		const FAttack& Attack = Attacks[AttackIndex];
+
+		int64 TotalAttacks = 0;
+		int64 TotalHits = 0;
+		double TotalTimeToHit = 0.0;
+
+		for (int32 Match = 0; Match < NumMatches; ++Match)
+		{
+			TotalAttacks += AttackCounts[Match * NumAttacks + AttackIndex];
+			TotalHits += HitCounts[Match * NumAttacks + AttackIndex];
+			TotalTimeToHit += TimesToHit[Match * NumAttacks + AttackIndex];
+		}
+
+		Report += FString::Printf(TEXT("%s,%d,%.0f,%.0f,%.0f,%.1f,%lld,%lld,%.3f,%.0f") LINE_TERMINATOR, *Attack.Row.ToString(), Attack.Section,
+			Attack.Startup * 1000.f, Attack.Active * 1000.f, (Attack.Duration - Attack.Startup - Attack.Active) * 1000.f, Attack.Reach,
+			TotalAttacks, TotalHits, TotalAttacks > 0 ? double(TotalHits) / TotalAttacks : 0.0, TotalHits > 0 ? TotalTimeToHit * 1000.0 / TotalHits : 0.0);
+	}
+
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Balance") / FString::Printf(TEXT("Matchups-%s.csv"), *FDateTime::Now().ToString());
+
+	if (!FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		UE_LOG(LogThePunch, Error, TEXT("Could not write %s"), *ReportPath);
+		return 1;
+	}
+
+	UE_LOG(LogThePunch, Display, TEXT("Simulated %d matches of %d bots in %.2f s (%.0f matches/s), report in %s"), NumMatches, Bots.Num(), Seconds, NumMatches / FMath::Max(Seconds, 0.001), *ReportPath);
+
+	return 0;
+}
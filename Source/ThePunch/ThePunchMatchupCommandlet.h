@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ThePunchMatchupCommandlet.generated.h"
+
+/**
+ * Balance sweep without playing: bots fight thousands of matches on a line, in parallel on
+ * every core, with the startup, active and recovery times of each start_N section and the
+ * reach of its hitboxes read from the attack montages of the data table.
+ *   UE4Editor-Cmd ThePunch.uproject -run=ThePunchMatchup -Matches=10000 -Seed=1 -HitsToWin=5
+ * Every bot plays every other bot; one bot per data table row only uses that row, the mixed
+ * bot picks any attack. Win rates per matchup, hits per attack and the average time to hit
+ * go to Saved/Balance/Matchups-<time>.csv.
+ */
+UCLASS()
+class UThePunchMatchupCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UThePunchMatchupCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
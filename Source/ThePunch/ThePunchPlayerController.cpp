@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchPlayerController.h"
+#include "ThePunchGameMode.h"
+#include "Engine/World.h"
+
+void AThePunchPlayerController::PawnLeavingGame()
+{
+	AThePunchGameMode* GameMode = GetWorld()->GetAuthGameMode<AThePunchGameMode>();
+	APawn* LeavingPawn = GetPawn();
+
+	// the next player to join gets the parked fighter
+	if (GameMode && GameMode->ReleaseFighter(LeavingPawn))
+	{
+		SetPawn(NULL);
+		return;
+	}
+
+	Super::PawnLeavingGame();
+}
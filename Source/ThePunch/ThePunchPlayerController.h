@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/PlayerController.h"
+#include "ThePunchPlayerController.generated.h"
+
+/**
+ * Player controller of the match. When its player logs out, the fighter goes back to the
+ * game state's actor pool through AThePunchGameMode::ReleaseFighter instead of being destroyed.
+ */
+UCLASS()
+class THEPUNCH_API AThePunchPlayerController : public APlayerController
+{
+	GENERATED_BODY()
+
+public:
+	// called on the server when the player leaves while still possessing a fighter
+	virtual void PawnLeavingGame() override;
+};
@@ -0,0 +1,359 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ThePunchSoakDirector.h"
+#include "ThePunch.h"
+#include "ThePunchCharacter.h"
+#include "ThePunchGameState.h"
+#include "CombatFrameArena.h"
+#include "Components/AudioComponent.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectIterator.h"
+
+// counts the live objects of a class, slow; only used once per sample
+template<typename ObjectType>
+static int32 CountObjects()
+{
+	int32 Count = 0;
+
+	for (TObjectIterator<ObjectType> It; It; ++It)
+	{
+		++Count;
+	}
+
+	return Count;
+}
+
+AThePunchSoakDirector::AThePunchSoakDirector()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	DurationMinutes = 240.f;
+	NumPairs = 8;
+	SampleInterval = 60.f;
+	GrowthWindow = 10;
+	GrowthThresholdPercent = 5.f;
+	RespawnInterval = 30.f;
+
+	StartTime = 0.f;
+	NextSampleTime = 0.f;
+	NextRespawnTime = 0.f;
+	NextRespawnPair = 0;
+	bSamplePending = false;
+	bFailed = false;
+}
+
+bool AThePunchSoakDirector::IsSoakRequested()
+{
+	return FParse::Param(FCommandLine::Get(), TEXT("soak"));
+}
+
+void AThePunchSoakDirector::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FParse::Value(FCommandLine::Get(), TEXT("SoakMinutes="), DurationMinutes);
+	FParse::Value(FCommandLine::Get(), TEXT("SoakPairs="), NumPairs);
+	FParse::Value(FCommandLine::Get(), TEXT("SoakInterval="), SampleInterval);
+	FParse::Value(FCommandLine::Get(), TEXT("SoakWindow="), GrowthWindow);
+	FParse::Value(FCommandLine::Get(), TEXT("SoakGrowthPercent="), GrowthThresholdPercent);
+
+	GrowthWindow = FMath::Max(GrowthWindow, 2);
+
+	const TCHAR* SeriesNames[] = { TEXT("UObjects"), TEXT("UsedPhysicalMB"), TEXT("UsedVirtualMB"), TEXT("FrameArenaKB"), TEXT("RegisteredFighters"),
+		TEXT("AudioComponents"), TEXT("BoxComponents"), TEXT("MeshAttachments"), TEXT("ScreenMessages") };
+
+	FString Header = TEXT("Seconds");
+
+	for (const TCHAR* Name : SeriesNames)
+	{
+		FSeries NewSeries;
+		NewSeries.Name = Name;
+		NewSeries.bReported = false;
+		Series.Add(NewSeries);
+
+		Header += TEXT(",");
+		Header += Name;
+	}
+
+	// the allocator names its own stats, a column for each one it reports at the start
+	FGenericMemoryStats AllocatorStats;
+	GMalloc->GetAllocatorStats(AllocatorStats);
+
+	for (const TPair<FString, SIZE_T>& Stat : AllocatorStats.Data)
+	{
+		FSeries NewSeries;
+		NewSeries.Name = TEXT("Malloc.");
+		NewSeries.AllocatorStat = Stat.Key;
+		NewSeries.bReported = false;
+		Series.Add(NewSeries);
+
+		Header += TEXT(",");
+		Header += NewSeries.Name + Stat.Key;
+	}
+
+	OutputPath = FPaths::ProjectSavedDir() / TEXT("Soak") / FString::Printf(TEXT("Soak-%s.csv"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(Header + LINE_TERMINATOR, *OutputPath);
+
+	for (int32 PairIndex = 0; PairIndex < NumPairs; ++PairIndex)
+	{
+		SpawnPair(PairIndex);
+	}
+
+	StartTime = GetWorld()->GetTimeSeconds();
+	NextSampleTime = StartTime + SampleInterval;
+	NextRespawnTime = StartTime + RespawnInterval;
+
+	UE_LOG(LogThePunch, Display, TEXT("Soak: %d fighter pairs for %.0f minutes, sampling every %.0f s into %s"), NumPairs, DurationMinutes, SampleInterval, *OutputPath);
+
+	// per tag numbers come from the memory tracker's own csv, written next to this one's samples
+	UE_LOG(LogThePunch, Display, TEXT("Soak: %s"), FParse::Param(FCommandLine::Get(), TEXT("LLM"))
+		? TEXT("LLM tags are written by -LLMCSV to Saved/Profiling/LLM") : TEXT("start with -LLM -LLMCSV for per tag memory series"));
+}
+
+void AThePunchSoakDirector::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (int32 PairIndex = 0; PairIndex < NumPairs; ++PairIndex)
+	{
+		DestroyPair(PairIndex);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AThePunchSoakDirector::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	RunScript();
+
+	// churn actors and components too, not just combat state
+	if (Now >= NextRespawnTime && NumPairs > 0)
+	{
+		DestroyPair(NextRespawnPair);
+		SpawnPair(NextRespawnPair);
+
+		NextRespawnPair = (NextRespawnPair + 1) % NumPairs;
+		NextRespawnTime = Now + RespawnInterval;
+	}
+
+	if (bSamplePending)
+	{
+		bSamplePending = false;
+		TakeSample();
+	}
+	else if (Now >= NextSampleTime)
+	{
+		// objects waiting for collection are not leaks, collect before counting
+		GEngine->ForceGarbageCollection(true);
+
+		bSamplePending = true;
+		NextSampleTime = Now + SampleInterval;
+	}
+
+	if (Now - StartTime >= DurationMinutes * 60.f)
+	{
+		Finish();
+	}
+}
+
+void AThePunchSoakDirector::RunScript()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (int32 Index = 0; Index < Fighters.Num(); ++Index)
+	{
+		AThePunchCharacter* Fighter = Fighters[Index];
+		AThePunchCharacter* Opponent = Fighters[Index ^ 1];
+
+		if (Fighter == NULL || Opponent == NULL || Now < NextActionTimes[Index] || Fighter->GetCurrentMontage() != NULL)
+		{
+			continue;
+		}
+
+		NextActionTimes[Index] = Now + FMath::FRandRange(0.3f, 1.5f);
+
+		const float Action = FMath::FRand();
+
+		if (Action < 0.5f)
+		{
+			// montage, socket re-attachment of the melee boxes and attack notifies
+			Fighter->AttackInput(FMath::RandBool() ? EAttackType::MELEE_FIST : EAttackType::MELEE_KICK);
+		}
+		else if (Action < 0.75f)
+		{
+			// hit handling, audio activation and hit reactions
+			FHitResult Hit(Opponent, Opponent->GetCapsuleComponent(), Opponent->GetActorLocation(), (Opponent->GetActorLocation() - Fighter->GetActorLocation()).GetSafeNormal());
+
+			Fighter->OnAttackHit(NULL, Opponent, Opponent->GetCapsuleComponent(), FVector::ZeroVector, Hit);
+		}
+		else if (Action < 0.9f)
+		{
+			// debug message push
+			Fighter->Log(ELogLevel::INFO, TEXT("Soak"));
+		}
+		else
+		{
+			Fighter->FireLineTrace();
+		}
+	}
+}
+
+void AThePunchSoakDirector::SpawnPair(int32 PairIndex)
+{
+	const AGameModeBase* GameMode = GetWorld()->GetAuthGameMode();
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+	UClass* FighterClass = GameMode && GameMode->DefaultPawnClass ? *GameMode->DefaultPawnClass : AThePunchCharacter::StaticClass();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	Fighters.SetNumZeroed(FMath::Max(Fighters.Num(), NumPairs * 2));
+	NextActionTimes.SetNumZeroed(Fighters.Num());
+
+	// pairs stand in a row, far enough apart to stay out of each other's way
+	const FVector Center = GetActorLocation() + FVector(0.f, PairIndex * 1000.f, 200.f);
+
+	for (int32 Side = 0; Side < 2; ++Side)
+	{
+		const FVector Location = Center + FVector(Side == 0 ? -75.f : 75.f, 0.f, 0.f);
+		const FRotator Rotation(0.f, Side == 0 ? 0.f : 180.f, 0.f);
+
+		// respawns go through the pool like in a match, reuse must not leak either
+		Fighters[PairIndex * 2 + Side] = GameState
+			? GameState->GetActorPool().Acquire<AThePunchCharacter>(GetWorld(), FighterClass, FTransform(Rotation, Location))
+			: GetWorld()->SpawnActor<AThePunchCharacter>(FighterClass, Location, Rotation, SpawnParams);
+	}
+}
+
+void AThePunchSoakDirector::DestroyPair(int32 PairIndex)
+{
+	AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	for (int32 Side = 0; Side < 2; ++Side)
+	{
+		const int32 Index = PairIndex * 2 + Side;
+
+		if (Fighters.IsValidIndex(Index) && Fighters[Index])
+		{
+			if (GameState)
+			{
+				GameState->GetActorPool().Release(Fighters[Index]);
+			}
+			else
+			{
+				Fighters[Index]->Destroy();
+			}
+
+			Fighters[Index] = NULL;
+		}
+	}
+}
+
+void AThePunchSoakDirector::TakeSample()
+{
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	const AThePunchGameState* GameState = GetWorld()->GetGameState<AThePunchGameState>();
+
+	int32 MeshAttachments = 0;
+
+	for (const AThePunchCharacter* Fighter : Fighters)
+	{
+		if (Fighter)
+		{
+			MeshAttachments += Fighter->GetMesh()->GetAttachChildren().Num();
+		}
+	}
+
+	TArray<double> Values =
+	{
+		(double)GUObjectArray.GetObjectArrayNumMinusAvailable(),
+		MemoryStats.UsedPhysical / (1024.0 * 1024.0),
+		MemoryStats.UsedVirtual / (1024.0 * 1024.0),
+		FCombatFrameArena::Get().GetBytesReserved() / 1024.0,
+		GameState ? (double)GameState->GetFighters().Num() : 0.0,
+		(double)CountObjects<UAudioComponent>(),
+		(double)CountObjects<UBoxComponent>(),
+		(double)MeshAttachments,
+		(double)(GEngine->ScreenMessages.Num() + GEngine->PriorityScreenMessages.Num())
+	};
+
+	FGenericMemoryStats AllocatorStats;
+	GMalloc->GetAllocatorStats(AllocatorStats);
+
+	for (int32 Index = Values.Num(); Index < Series.Num(); ++Index)
+	{
+		const SIZE_T* Bytes = AllocatorStats.Data.Find(Series[Index].AllocatorStat);
+		Values.Add(Bytes ? *Bytes / (1024.0 * 1024.0) : 0.0);
+	}
+
+	check(Values.Num() == Series.Num());
+
+	FString Line = FString::Printf(TEXT("%.0f"), GetWorld()->GetTimeSeconds() - StartTime);
+
+	for (int32 Index = 0; Index < Series.Num(); ++Index)
+	{
+		FSeries& Entry = Series[Index];
+		Entry.Samples.Add(Values[Index]);
+
+		Line += FString::Printf(TEXT(",%.2f"), Values[Index]);
+
+		if (!Entry.bReported && IsGrowing(Entry))
+		{
+			const double First = Entry.Samples[Entry.Samples.Num() - GrowthWindow];
+
+			UE_LOG(LogThePunch, Error, TEXT("Soak: %s%s grew on each of the last %d samples, %.2f -> %.2f"), Entry.Name, *Entry.AllocatorStat, GrowthWindow, First, Values[Index]);
+
+			Entry.bReported = true;
+			bFailed = true;
+		}
+	}
+
+	FFileHelper::SaveStringToFile(Line + LINE_TERMINATOR, *OutputPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
+
+bool AThePunchSoakDirector::IsGrowing(const FSeries& Entry) const
+{
+	// the first window is warm up: pools, caches and the frame arena fill up
+	if (Entry.Samples.Num() < GrowthWindow * 2)
+	{
+		return false;
+	}
+
+	const int32 Start = Entry.Samples.Num() - GrowthWindow;
+
+	for (int32 Index = Start + 1; Index < Entry.Samples.Num(); ++Index)
+	{
+		if (Entry.Samples[Index] < Entry.Samples[Index - 1])
+		{
+			return false;
+		}
+	}
+
+	const double First = Entry.Samples[Start];
+	const double Last = Entry.Samples.Last();
+
+	return Last > First * (1.0 + GrowthThresholdPercent / 100.0);
+}
+
+void AThePunchSoakDirector::Finish()
+{
+	UE_LOG(LogThePunch, Display, TEXT("Soak finished %s, time series in %s"), bFailed ? TEXT("with growth") : TEXT("clean"), *OutputPath);
+
+	FPlatformMisc::RequestExitWithStatus(false, bFailed ? 1 : 0);
+
+	SetActorTickEnabled(false);
+}
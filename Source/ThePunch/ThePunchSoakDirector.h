@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ThePunchSoakDirector.generated.h"
+
+class AThePunchCharacter;
+
+/**
+ * Long running leak check. Spawned by the game mode when the process starts with -soak:
+ *   ThePunch -game -nullrhi -soak -SoakMinutes=240 -SoakPairs=8 -SoakInterval=60
+ * Pairs of fighters attack, hit, trace and log at random for the whole run and are
+ * respawned regularly. Every SoakInterval seconds, after a garbage collection, the
+ * director samples object counts, allocator stats (FMalloc::GetAllocatorStats, in MB) and
+ * the combat subsystems into Saved/Soak/Soak-<time>.csv. Per LLM tag series come from the
+ * engine's own -LLM -LLMCSV output, which samples on its own clock. A series that only grows over SoakWindow samples by
+ * more than SoakGrowthPercent fails the run; the process exits with status 1 then.
+ */
+UCLASS()
+class THEPUNCH_API AThePunchSoakDirector : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AThePunchSoakDirector();
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** true when the command line asks for a soak run **/
+	static bool IsSoakRequested();
+
+	// length of the run
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Soak)
+	float DurationMinutes;
+
+	// fighters fight in pairs
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Soak)
+	int32 NumPairs;
+
+	// seconds between samples
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Soak)
+	float SampleInterval;
+
+	// samples a series must keep growing over before it counts as a leak
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Soak)
+	int32 GrowthWindow;
+
+	// growth over the window, in percent of its first sample, that fails the run
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Soak)
+	float GrowthThresholdPercent;
+
+	// seconds between respawns of one fighter pair
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Soak)
+	float RespawnInterval;
+
+private:
+	struct FSeries
+	{
+		const TCHAR* Name;
+
+		// key in FGenericMemoryStats for the allocator's own series, in MB; empty for the others
+		FString AllocatorStat;
+
+		TArray<double> Samples;
+
+		bool bReported;
+	};
+
+	// picks a random action for every idle fighter
+	void RunScript();
+
+	void SpawnPair(int32 PairIndex);
+
+	void DestroyPair(int32 PairIndex);
+
+	// reads every series and appends a line to the time series file
+	void TakeSample();
+
+	// true when a series grew on every sample of the window by more than the threshold
+	bool IsGrowing(const FSeries& Series) const;
+
+	void Finish();
+
+	UPROPERTY(Transient)
+	TArray<AThePunchCharacter*> Fighters;
+
+	// world time each fighter acts next
+	TArray<float> NextActionTimes;
+
+	TArray<FSeries> Series;
+
+	FString OutputPath;
+
+	float StartTime;
+
+	float NextSampleTime;
+
+	float NextRespawnTime;
+
+	int32 NextRespawnPair;
+
+	// garbage collection was requested, the sample is taken on the next tick
+	bool bSamplePending;
+
+	bool bFailed;
+};
@@ -0,0 +1,188 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "ThePunchHooks.h"
+#include "ThePunchCharacter.h"
+#include "CombatLatency.h"
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Modules/ModuleManager.h"
+#include "Sound/SoundCue.h"
+#include "UObject/SoftObjectPath.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogThePunchAudio, Log, All);
+
+static const FName PunchAudioName(TEXT("PunchAudioComponent"));
+static const FName PunchThrowAudioName(TEXT("PunchThrowAudioComponent"));
+
+// the cues only this module plays, so the core and servers never load them; set in DefaultGame.ini under [ThePunchAudio]
+static FSoftObjectPath PunchSoundPath(TEXT("/Game/Resources/Audio/PunchSoundCue.PunchSoundCue"));
+static FSoftObjectPath PunchThrowSoundPath(TEXT("/Game/Resources/Audio/PunchThrowSoundCue.PunchThrowSoundCue"));
+
+static USoundCue* PunchSound = NULL;
+static USoundCue* PunchThrowSound = NULL;
+
+/** punch and throw sounds of the fighters, see FThePunchHooks */
+class FThePunchAudioModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override
+	{
+		FString Path;
+
+		if (GConfig && GConfig->GetString(TEXT("ThePunchAudio"), TEXT("PunchSound"), Path, GGameIni))
+		{
+			PunchSoundPath = Path;
+		}
+
+		if (GConfig && GConfig->GetString(TEXT("ThePunchAudio"), TEXT("PunchThrowSound"), Path, GGameIni))
+		{
+			PunchThrowSoundPath = Path;
+		}
+
+		FighterBeginPlayHandle = FThePunchHooks::OnFighterBeginPlay.AddStatic(&FThePunchAudioModule::AddFighterAudio);
+		AttackThrownHandle = FThePunchHooks::OnAttackThrown.AddStatic(&FThePunchAudioModule::PlayThrowSound);
+		AttackHitHandle = FThePunchHooks::OnAttackHit.AddStatic(&FThePunchAudioModule::PlayPunchSound);
+		CombatStateResetHandle = FThePunchHooks::OnCombatStateReset.AddStatic(&FThePunchAudioModule::StopFighterAudio);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FThePunchHooks::OnFighterBeginPlay.Remove(FighterBeginPlayHandle);
+		FThePunchHooks::OnAttackThrown.Remove(AttackThrownHandle);
+		FThePunchHooks::OnAttackHit.Remove(AttackHitHandle);
+		FThePunchHooks::OnCombatStateReset.Remove(CombatStateResetHandle);
+
+		if (UObjectInitialized())
+		{
+			ReleaseSound(PunchSound);
+			ReleaseSound(PunchThrowSound);
+		}
+	}
+
+private:
+	// the components are added at runtime, a fighter without them plays nothing
+	static UAudioComponent* FindAudio(AThePunchCharacter* Fighter, FName Name)
+	{
+		TInlineComponentArray<UAudioComponent*> AudioComponents(Fighter);
+
+		for (UAudioComponent* Audio : AudioComponents)
+		{
+			if (Audio->GetFName() == Name)
+			{
+				return Audio;
+			}
+		}
+
+		return NULL;
+	}
+
+	// loads a cue on first use and keeps it loaded with the module, a path that fails is not tried again
+	static USoundCue* LoadSound(FSoftObjectPath& Path, USoundCue*& Sound)
+	{
+		if (Sound == NULL && Path.IsValid())
+		{
+			Sound = Cast<USoundCue>(Path.TryLoad());
+
+			if (Sound)
+			{
+				Sound->AddToRoot();
+			}
+			else
+			{
+				UE_LOG(LogThePunchAudio, Warning, TEXT("Sound cue %s could not be loaded, fighters play no sound for it"), *Path.ToString());
+				Path.Reset();
+			}
+		}
+
+		return Sound;
+	}
+
+	static void ReleaseSound(USoundCue*& Sound)
+	{
+		if (Sound)
+		{
+			Sound->RemoveFromRoot();
+			Sound = NULL;
+		}
+	}
+
+	static void AddAudio(AThePunchCharacter* Fighter, FName Name, USoundCue* Sound)
+	{
+		if (Sound == NULL || FindAudio(Fighter, Name))
+		{
+			return;
+		}
+
+		UAudioComponent* Audio = NewObject<UAudioComponent>(Fighter, Name);
+		Audio->bAutoActivate = false;
+		Audio->SetupAttachment(Fighter->GetRootComponent());
+		Audio->SetSound(Sound);
+		Audio->RegisterComponent();
+
+		Fighter->AddInstanceComponent(Audio);
+	}
+
+	static void AddFighterAudio(AThePunchCharacter* Fighter)
+	{
+		// -nosound and headless runs have no device to play on
+		if (Fighter->IsNetMode(NM_DedicatedServer) || Fighter->GetWorld()->GetAudioDevice() == NULL)
+		{
+			return;
+		}
+
+		AddAudio(Fighter, PunchAudioName, LoadSound(PunchSoundPath, PunchSound));
+		AddAudio(Fighter, PunchThrowAudioName, LoadSound(PunchThrowSoundPath, PunchThrowSound));
+	}
+
+	static void PlayThrowSound(AThePunchCharacter* Fighter)
+	{
+		UAudioComponent* Audio = FindAudio(Fighter, PunchThrowAudioName);
+
+		if (Audio && !Audio->IsPlaying())
+		{
+			Audio->Play(0.f);
+		}
+	}
+
+	static void PlayPunchSound(AThePunchCharacter* Fighter, uint64 HitCycles)
+	{
+		UAudioComponent* Audio = FindAudio(Fighter, PunchAudioName);
+
+		if (Audio && !Audio->IsPlaying())
+		{
+			// activate the sound if it has not been already activated
+			if (!Audio->IsActive())
+			{
+				Audio->Activate(true);
+			}
+
+			// random pitch between 1 and 1.3
+			Audio->SetPitchMultiplier(FMath::RandRange(1.0f, 1.3f));
+			Audio->Play(0.f);
+
+			FCombatLatency::Record(ECombatLatency::HIT_TO_AUDIO, HitCycles);
+		}
+	}
+
+	static void StopFighterAudio(AThePunchCharacter* Fighter)
+	{
+		TInlineComponentArray<UAudioComponent*> AudioComponents(Fighter);
+
+		for (UAudioComponent* Audio : AudioComponents)
+		{
+			Audio->Stop();
+		}
+	}
+
+	FDelegateHandle FighterBeginPlayHandle;
+
+	FDelegateHandle AttackThrownHandle;
+
+	FDelegateHandle AttackHitHandle;
+
+	FDelegateHandle CombatStateResetHandle;
+};
+
+IMPLEMENT_MODULE(FThePunchAudioModule, ThePunchAudio);
@@ -0,0 +1,46 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "ThePunchHooks.h"
+#include "ThePunchCharacter.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+#include "Modules/ModuleManager.h"
+
+/** debug visualization of the combat traces, see FThePunchHooks */
+class FThePunchDebugModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override
+	{
+		LineTraceHandle = FThePunchHooks::OnLineTraceFinished.AddStatic(&FThePunchDebugModule::DrawLineTrace);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FThePunchHooks::OnLineTraceFinished.Remove(LineTraceHandle);
+	}
+
+private:
+	// green with a box on the impact when the trace hit, purple when it found nothing
+	static void DrawLineTrace(const AThePunchCharacter* Fighter, const FVector& Start, const FVector& End, const FHitResult* Hit)
+	{
+#if ENABLE_DRAW_DEBUG
+		UWorld* World = Fighter->GetWorld();
+
+		if (Hit)
+		{
+			DrawDebugLine(World, Start, End, FColor::Green, false, 5.f, ECC_WorldStatic, 1.f);
+			DrawDebugBox(World, Hit->ImpactPoint, FVector(2.f, 2.f, 2.f), FColor::Blue, false, 5.f, ECC_WorldStatic, 1.f);
+		}
+		else
+		{
+			DrawDebugLine(World, Start, End, FColor::Purple, false, 5.f, ECC_WorldStatic, 1.f);
+		}
+#endif
+	}
+
+	FDelegateHandle LineTraceHandle;
+};
+
+IMPLEMENT_MODULE(FThePunchDebugModule, ThePunchDebug);
@@ -9,5 +9,8 @@ public class ThePunchEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 		ExtraModuleNames.Add("ThePunch");
+
+		// optional feature modules, loaded at startup by FThePunchHooks::LoadOptionalModules
+		ExtraModuleNames.AddRange(new string[] { "ThePunchVR", "ThePunchAudio", "ThePunchDebug" });
 	}
 }
@@ -0,0 +1,13 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+using System.Collections.Generic;
+
+public class ThePunchServerTarget : TargetRules
+{
+	public ThePunchServerTarget(TargetInfo Target) : base(Target)
+	{
+		Type = TargetType.Server;
+		ExtraModuleNames.Add("ThePunch");
+	}
+}
@@ -0,0 +1,62 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "ThePunchHooks.h"
+#include "ThePunchCharacter.h"
+#include "HeadMountedDisplayFunctionLibrary.h"
+#include "Components/InputComponent.h"
+#include "Modules/ModuleManager.h"
+
+/** VR headset reset and touch input for the fighters, see FThePunchHooks */
+class FThePunchVRModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override
+	{
+		SetupInputHandle = FThePunchHooks::OnSetupFighterInput.AddStatic(&FThePunchVRModule::SetupFighterInput);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FThePunchHooks::OnSetupFighterInput.Remove(SetupInputHandle);
+	}
+
+private:
+	static void SetupFighterInput(AThePunchCharacter* Fighter, UInputComponent* InputComponent)
+	{
+		const TWeakObjectPtr<AThePunchCharacter> WeakFighter(Fighter);
+
+		// handle touch devices, a touch jumps
+		FInputTouchBinding TouchPressed(IE_Pressed);
+		TouchPressed.TouchDelegate.GetDelegateForManualSet().BindLambda([WeakFighter](ETouchIndex::Type FingerIndex, FVector Location)
+		{
+			if (WeakFighter.IsValid())
+			{
+				WeakFighter->Jump();
+			}
+		});
+		InputComponent->TouchBindings.Add(TouchPressed);
+
+		FInputTouchBinding TouchReleased(IE_Released);
+		TouchReleased.TouchDelegate.GetDelegateForManualSet().BindLambda([WeakFighter](ETouchIndex::Type FingerIndex, FVector Location)
+		{
+			if (WeakFighter.IsValid())
+			{
+				WeakFighter->StopJumping();
+			}
+		});
+		InputComponent->TouchBindings.Add(TouchReleased);
+
+		// VR headset functionality
+		FInputActionBinding ResetVR("ResetVR", IE_Pressed);
+		ResetVR.ActionDelegate.GetDelegateForManualSet().BindLambda([]()
+		{
+			UHeadMountedDisplayFunctionLibrary::ResetOrientationAndPosition();
+		});
+		InputComponent->AddActionBinding(ResetVR);
+	}
+
+	FDelegateHandle SetupInputHandle;
+};
+
+IMPLEMENT_MODULE(FThePunchVRModule, ThePunchVR);